@@ -0,0 +1,115 @@
+// Timings of the embedding API, run by hand: ./bench.exe [name...]. Not part
+// of ctest, since the numbers depend on the machine.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <latch>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <script/script.h>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+// Nanoseconds per call of `call`, run `count` times after a warm-up.
+double perCall(std::uint64_t count, const std::function<void()>& call) {
+    for (std::uint64_t i = 0; i < count / 10; ++i) {
+        call();
+    }
+    const auto start = Clock::now();
+    for (std::uint64_t i = 0; i < count; ++i) {
+        call();
+    }
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / static_cast<double>(count);
+}
+
+std::shared_ptr<const script::CompiledScript> compile(std::string_view source, std::vector<std::string> inputs) {
+    std::vector<std::string> errors;
+    auto compiled = script::CompiledScript::Compile(source, std::move(inputs), errors);
+    if (!compiled) {
+        for (const auto& error : errors) {
+            std::cerr << error << '\n';
+        }
+        std::exit(1);
+    }
+    return compiled;
+}
+
+// What Execute costs beyond the script itself: converting the inputs and
+// result, resetting the heap and budget, and the sweep at the end.
+void executeOverhead() {
+    const auto empty = compile("x", {"x"});
+    const auto closures = compile("let f = fn(a) { fn(b) { a + b } }; f(x)(1)", {"x"});
+    const std::vector<script::Value> inputs{int64_t{41}};
+    const script::Limits limits{.fuel = 1000000, .timeout = std::chrono::seconds{1}, .memory = 1 << 20};
+
+    fmt::print("execute overhead (ns per call)\n");
+    fmt::print("  {:<28} {:>8.1f}\n", "returns its input", perCall(1000000, [&] { empty->Execute(inputs); }));
+    fmt::print("  {:<28} {:>8.1f}\n", "with limits", perCall(1000000, [&] { empty->Execute(inputs, limits); }));
+    fmt::print("  {:<28} {:>8.1f}\n", "makes two closures", perCall(1000000, [&] { closures->Execute(inputs); }));
+}
+
+// Executions per second of one compiled script shared by 1, 2, 4... threads,
+// up to twice the hardware threads. Executions share nothing but the loaded
+// library, so the total should grow with the threads until the cores run out.
+void threadScaling() {
+    const auto fib = compile("let fib = fn(n) { if (n < 2) { n } else { fib(n - 1) + fib(n - 2) } }; fib(x)", {"x"});
+    const std::vector<script::Value> inputs{int64_t{15}};
+    const auto hardware = std::max(1u, std::thread::hardware_concurrency());
+    constexpr auto Duration = std::chrono::milliseconds{500};
+
+    fmt::print("throughput of fib(15) ({} hardware threads)\n", hardware);
+    fmt::print("  {:>7} {:>14} {:>14}\n", "threads", "executions/s", "per thread");
+    for (unsigned count = 1; count <= 2 * hardware; count *= 2) {
+        std::vector<std::uint64_t> executions(count);
+        std::vector<std::thread> threads;
+        std::latch start{static_cast<std::ptrdiff_t>(count) + 1};
+        for (unsigned i = 0; i < count; ++i) {
+            threads.emplace_back([&, i] {
+                start.arrive_and_wait();
+                const auto end = Clock::now() + Duration;
+                while (Clock::now() < end) {
+                    fib->Execute(inputs);
+                    ++executions[i];
+                }
+            });
+        }
+        start.arrive_and_wait();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        const auto total = static_cast<double>(std::accumulate(executions.begin(), executions.end(), std::uint64_t{})) /
+                           std::chrono::duration<double>(Duration).count();
+        fmt::print("  {:>7} {:>14.0f} {:>14.0f}\n", count, total, total / count);
+    }
+}
+
+const std::vector<std::pair<std::string_view, void (*)()>> benchmarks{
+    {"execute", executeOverhead},
+    {"threads", threadScaling},
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const std::vector<std::string_view> names(argv + 1, argv + argc);
+    for (const auto& [name, run] : benchmarks) {
+        if (names.empty() || std::ranges::find(names, name) != names.end()) {
+            run();
+        }
+    }
+}
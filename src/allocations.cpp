@@ -0,0 +1,34 @@
+// Replaces the global allocation functions so that every new expression,
+// including those inside the standard library, is counted by stats::Allocated.
+// Linked into monkey.exe and the tests only, never into libmonkey. The array
+// and nothrow forms forward to this one.
+
+#include <cstdlib>
+#include <new>
+
+#include <stats/stats.h>
+
+void* operator new(std::size_t size) {
+    stats::CountAllocation(size);
+    if (size == 0) {
+        size = 1;
+    }
+    while (true) {
+        if (const auto memory = std::malloc(size)) {
+            return memory;
+        }
+        const auto handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc{};
+        }
+        handler();
+    }
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
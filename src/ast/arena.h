@@ -0,0 +1,79 @@
+#ifndef ast_arena_h
+#define ast_arena_h
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+
+namespace ast {
+
+// Bump-pointer storage for the nodes of one parse. Nodes are carved out of
+// large chunks back to back and the chunks are released all at once, when the
+// last node that was allocated from them goes away.
+class Arena {
+public:
+    static constexpr std::size_t DefaultChunkSize = 64 * 1024;
+
+    explicit Arena(std::size_t chunkSize = DefaultChunkSize) :
+        m_resource{chunkSize}
+    {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(std::size_t bytes, std::size_t alignment) {
+        m_allocated += bytes;
+        return m_resource.allocate(bytes, alignment);
+    }
+
+    std::size_t allocated() const {
+        return m_allocated;
+    }
+
+    // Returns every chunk for reuse. Only valid once no node allocated from
+    // the arena is alive any more.
+    void release() {
+        m_resource.release();
+        m_allocated = 0;
+    }
+
+private:
+    std::pmr::monotonic_buffer_resource m_resource;
+    std::size_t m_allocated{};
+};
+
+// Every node keeps its arena alive through the allocator stored in its
+// shared_ptr control block, so a node may safely outlive the Parser and the
+// Program it came from.
+template <typename T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    explicit ArenaAllocator(std::shared_ptr<Arena> a) : arena(std::move(a)) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, std::size_t) noexcept {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const {
+        return arena == other.arena;
+    }
+
+    std::shared_ptr<Arena> arena;
+};
+
+template <typename T, typename... Args>
+std::shared_ptr<T> MakeNode(const std::shared_ptr<Arena>& arena, Args&&... args) {
+    return std::allocate_shared<T>(ArenaAllocator<T>{arena}, std::forward<Args>(args)...);
+}
+
+} // namespace ast
+
+#endif // ast_arena_h
@@ -0,0 +1,251 @@
+#include "ast.h"
+
+#include <algorithm>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+
+#include <token/token.h>
+
+namespace
+{
+
+// Children of `node` in source order; null children are left out.
+void children(ast::Node* node, std::vector<ast::Node*>& out) {
+    const auto add = [&out](ast::Node* child) {
+        if (child) {
+            out.push_back(child);
+        }
+    };
+    if (const auto let = dynamic_cast<ast::LetStatement*>(node)) {
+        add(let->value.get());
+    } else if (const auto ret = dynamic_cast<ast::ReturnStatement*>(node)) {
+        add(ret->returnValue.get());
+    } else if (const auto exp = dynamic_cast<ast::ExpressionStatement*>(node)) {
+        add(exp->expression.get());
+    } else if (const auto block = dynamic_cast<ast::BlockStatement*>(node)) {
+        for (const auto& statement : block->statements) {
+            add(statement.get());
+        }
+    } else if (const auto prefix = dynamic_cast<ast::PrefixExpression*>(node)) {
+        add(prefix->right.get());
+    } else if (const auto infix = dynamic_cast<ast::InfixExpression*>(node)) {
+        add(infix->left.get());
+        add(infix->right.get());
+    } else if (const auto ifExp = dynamic_cast<ast::IfExpression*>(node)) {
+        add(ifExp->condition.get());
+        add(ifExp->consequence.get());
+        add(ifExp->alternative.get());
+    } else if (const auto literal = dynamic_cast<ast::FunctionLteral*>(node)) {
+        for (const auto& parameter : literal->parameters) {
+            add(parameter.get());
+        }
+        add(literal->body.get());
+    } else if (const auto call = dynamic_cast<ast::CallExpression*>(node)) {
+        add(call->function.get());
+        for (const auto& argument : call->arguments) {
+            add(argument.get());
+        }
+    }
+}
+
+std::string_view kind(ast::Node* node) {
+    if (dynamic_cast<ast::LetStatement*>(node)) {
+        return "LetStatement";
+    } else if (dynamic_cast<ast::ReturnStatement*>(node)) {
+        return "ReturnStatement";
+    } else if (dynamic_cast<ast::ExpressionStatement*>(node)) {
+        return "ExpressionStatement";
+    } else if (dynamic_cast<ast::BlockStatement*>(node)) {
+        return "BlockStatement";
+    } else if (dynamic_cast<ast::Identifier*>(node)) {
+        return "Identifier";
+    } else if (dynamic_cast<ast::IntegerLiteral*>(node)) {
+        return "IntegerLiteral";
+    } else if (dynamic_cast<ast::Boolean*>(node)) {
+        return "Boolean";
+    } else if (dynamic_cast<ast::PrefixExpression*>(node)) {
+        return "PrefixExpression";
+    } else if (dynamic_cast<ast::InfixExpression*>(node)) {
+        return "InfixExpression";
+    } else if (dynamic_cast<ast::IfExpression*>(node)) {
+        return "IfExpression";
+    } else if (dynamic_cast<ast::FunctionLteral*>(node)) {
+        return "FunctionLteral";
+    } else if (dynamic_cast<ast::CallExpression*>(node)) {
+        return "CallExpression";
+    }
+    return "Node";
+}
+
+} // namespace
+
+std::string_view ast::Spelling(Operator op) {
+    switch (op) {
+    case Operator::Bang:
+        return "!";
+    case Operator::Minus:
+        return "-";
+    case Operator::Plus:
+        return "+";
+    case Operator::Asterisk:
+        return "*";
+    case Operator::Slash:
+        return "/";
+    case Operator::LessThan:
+        return "<";
+    case Operator::GreaterThan:
+        return ">";
+    case Operator::Equal:
+        return "==";
+    case Operator::NotEqual:
+        return "!=";
+    }
+    return "";
+}
+
+ast::Operator ast::OperatorOf(std::string_view tokenType) {
+    static const std::unordered_map<std::string_view, Operator> operators{
+        {token::BANG, Operator::Bang},
+        {token::MINUS, Operator::Minus},
+        {token::PLUS, Operator::Plus},
+        {token::ASTERISK, Operator::Asterisk},
+        {token::SLASH, Operator::Slash},
+        {token::LT, Operator::LessThan},
+        {token::GT, Operator::GreaterThan},
+        {token::EQ, Operator::Equal},
+        {token::NOT_EQ, Operator::NotEqual},
+    };
+    return operators.at(tokenType);
+}
+
+std::string ast::Print(Node* node) {
+    using Item = std::variant<Node*, std::string_view>;
+
+    std::string out;
+    std::vector<Item> work{node};
+    std::vector<Item> parts;
+    while (!work.empty()) {
+        const auto item = work.back();
+        work.pop_back();
+        if (const auto text = std::get_if<std::string_view>(&item)) {
+            out += *text;
+            continue;
+        }
+
+        const auto current = std::get<Node*>(item);
+        parts.clear();
+        if (!current) {
+            continue;
+        } else if (const auto let = dynamic_cast<LetStatement*>(current)) {
+            parts = {"let ", let->name.value, " = ", let->value.get(), ";"};
+        } else if (const auto ret = dynamic_cast<ReturnStatement*>(current)) {
+            parts = {"return ", ret->returnValue.get(), ";"};
+        } else if (const auto exp = dynamic_cast<ExpressionStatement*>(current)) {
+            parts = {exp->expression.get()};
+        } else if (const auto block = dynamic_cast<BlockStatement*>(current)) {
+            for (const auto& statement : block->statements) {
+                parts.push_back(statement.get());
+            }
+        } else if (const auto prefix = dynamic_cast<PrefixExpression*>(current)) {
+            parts = {"(", Spelling(prefix->my_operator), prefix->right.get(), ")"};
+        } else if (const auto infix = dynamic_cast<InfixExpression*>(current)) {
+            parts = {"(", infix->left.get(), " ", Spelling(infix->my_operator), " ", infix->right.get(), ")"};
+        } else if (const auto ifExp = dynamic_cast<IfExpression*>(current)) {
+            parts = {"if", ifExp->condition.get(), " ", ifExp->consequence.get()};
+            if (ifExp->alternative) {
+                parts.insert(parts.end(), {"else ", ifExp->alternative.get()});
+            }
+        } else if (const auto literal = dynamic_cast<FunctionLteral*>(current)) {
+            parts = {"fn("};
+            for (const auto& parameter : literal->parameters) {
+                parts.insert(parts.end(), {parameter.get(), ", "});
+            }
+            parts.insert(parts.end(), {") ", literal->body.get()});
+        } else if (const auto call = dynamic_cast<CallExpression*>(current)) {
+            parts = {call->function.get(), "("};
+            for (std::size_t i = 0; i < call->arguments.size(); ++i) {
+                if (i > 0) {
+                    parts.push_back(", ");
+                }
+                parts.push_back(call->arguments[i].get());
+            }
+            parts.push_back(")");
+        } else {
+            // Leaves print themselves.
+            out += current->String();
+            continue;
+        }
+        work.insert(work.end(), parts.rbegin(), parts.rend());
+    }
+    return out;
+}
+
+std::size_t ast::Depth(Node* node) {
+    std::size_t deepest = 0;
+    std::vector<std::pair<Node*, std::size_t>> work{{node, 1}};
+    std::vector<Node*> below;
+    while (!work.empty()) {
+        const auto [current, depth] = work.back();
+        work.pop_back();
+        if (!current) {
+            continue;
+        }
+        deepest = std::max(deepest, depth);
+        below.clear();
+        children(current, below);
+        for (const auto child : below) {
+            work.emplace_back(child, depth + 1);
+        }
+    }
+    return deepest;
+}
+
+std::size_t ast::Depth(Program& program) {
+    std::size_t deepest = 0;
+    for (const auto& statement : program.statements) {
+        deepest = std::max(deepest, Depth(statement.get()));
+    }
+    return deepest;
+}
+
+std::map<std::string_view, std::size_t> ast::Census(Program& program) {
+    std::map<std::string_view, std::size_t> counts;
+    std::vector<Node*> work;
+    for (const auto& statement : program.statements) {
+        work.push_back(statement.get());
+    }
+    while (!work.empty()) {
+        const auto current = work.back();
+        work.pop_back();
+        ++counts[kind(current)];
+        // A let's name is a member rather than a child node.
+        if (dynamic_cast<LetStatement*>(current)) {
+            ++counts["Identifier"];
+        }
+        children(current, work);
+    }
+    return counts;
+}
+
+void ast::detail::Release(std::shared_ptr<Node> node) {
+    thread_local std::vector<std::shared_ptr<Node>> pending;
+    thread_local bool draining{};
+
+    if (!node || node.use_count() > 1) {
+        return;
+    }
+    pending.push_back(std::move(node));
+    if (draining) {
+        return;
+    }
+    draining = true;
+    while (!pending.empty()) {
+        // Destroying this node releases its children back into `pending`.
+        auto next = std::move(pending.back());
+        pending.pop_back();
+        next.reset();
+    }
+    draining = false;
+}
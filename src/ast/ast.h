@@ -1,11 +1,16 @@
 #ifndef ast_ast_h
 #define ast_ast_h
 
+#include <cstdint>
 #include <iostream>
+#include <map>
 #include <vector>
 #include <memory>
+#include <sstream>
+#include <string_view>
 
-#include <token/token.h>
+#include <ast/arena.h>
+#include <symbols/symbols.h>
 
 namespace ast {
 
@@ -14,6 +19,50 @@ struct Node {
     virtual std::string String() = 0;
 };
 
+// Renders a node without recursing on the C++ stack; String() of every node
+// with children goes through it, so arbitrarily deep trees print safely.
+std::string Print(Node* node);
+
+class Program;
+
+// Longest chain of nested nodes below and including `node`, computed without
+// recursion, for passes that do recurse to check before walking a tree.
+std::size_t Depth(Node* node);
+std::size_t Depth(Program& program);
+
+// Number of nodes of each kind in the program, keyed by class name.
+std::map<std::string_view, std::size_t> Census(Program& program);
+
+enum class Operator : uint8_t {
+    Bang,
+    Minus,
+    Plus,
+    Asterisk,
+    Slash,
+    LessThan,
+    GreaterThan,
+    Equal,
+    NotEqual,
+};
+
+// The operator's text in source, such as "!=".
+std::string_view Spelling(Operator op);
+
+// The operator written as a token of type `tokenType`; the parser only asks
+// for prefix and infix operator tokens.
+Operator OperatorOf(std::string_view tokenType);
+
+namespace detail
+{
+
+// Called by node destructors for their children. A child whose last reference
+// goes away is destroyed from a loop in the outermost call rather than from
+// inside its parent's destructor, so tearing down a deep tree takes constant
+// stack.
+void Release(std::shared_ptr<Node> node);
+
+} // namespace detail
+
 struct Statement : public Node {
     virtual std::string statementNode() = 0;
 };
@@ -40,38 +89,37 @@ public:
     }
 
    std::vector<std::shared_ptr<Statement>> statements;
+   // Where the parser allocated the nodes; passes that add nodes allocate
+   // them there too. Null for programs built by hand.
+   std::shared_ptr<Arena> arena;
 };
 
 struct Identifier : public Expression {
     std::string expressionNode() override { return ""; }
     std::string TokenLiteral() {
-        return this->token.literal;
+        return std::string{this->value};
     }
     std::string String() {
-        return this->value;
+        return std::string{this->value};
     }
 
-    token::Token token;
-    std::string value;
+    std::string_view value; // the interned text of `symbol`
+    symbols::Symbol symbol{};
 };
 
 struct LetStatement : public Statement {
     std::string statementNode() override { return ""; }
     std::string TokenLiteral() {
-        return this->token.literal;
+        return "let";
     }
     std::string String() override {
-        std::stringstream out;
-        out << this->TokenLiteral() << ' ' << name.String() << " = ";
+        return Print(this);
+    }
 
-        if (this->value) {
-            out << this->value->String();
-        }
-        out << ';';
-        return out.str();
+    ~LetStatement() {
+        detail::Release(std::move(this->value));
     }
 
-    token::Token token;
     Identifier name;
     std::shared_ptr<Expression> value;
 };
@@ -79,132 +127,128 @@ struct LetStatement : public Statement {
 struct ReturnStatement : public Statement {
     std::string statementNode() override { return ""; }
     std::string TokenLiteral() {
-        return this->token.literal;
+        return "return";
     }
     std::string String() override {
-        std::stringstream out;
-
-
-        out << this->TokenLiteral() << ' ';
-        if (this->returnValue) {
-            out << this->returnValue->String();
-        }
+        return Print(this);
+    }
 
-        out << ';';
-        return out.str();
+    ~ReturnStatement() {
+        detail::Release(std::move(this->returnValue));
     }
 
-    token::Token token;
     std::shared_ptr<Expression> returnValue;
 };
 
 struct ExpressionStatement : public Statement {
     std::string statementNode() override { return ""; }
     std::string TokenLiteral() {
-        return this->token.literal;
+        return this->expression ? this->expression->TokenLiteral() : "";
     }
     std::string String() override {
-        if (this->expression.get()) {
-            return this->expression->String();
-        }
-        return "";
+        return Print(this);
+    }
+
+    ~ExpressionStatement() {
+        detail::Release(std::move(this->expression));
     }
 
-    token::Token token;
     std::shared_ptr<Expression> expression;
 };
 
 struct IntegerLiteral : public Expression {
     std::string expressionNode() override { return ""; }
     std::string TokenLiteral() {
-        return this->token.literal;
+        return std::to_string(this->value);
     }
     std::string String() {
-        return this->token.literal;
+        return this->TokenLiteral();
     }
 
-    token::Token token;
     int64_t value{};
 };
 
 struct PrefixExpression : public Expression {
     std::string expressionNode() override { return ""; }
     std::string TokenLiteral() {
-        return this->token.literal;
+        return std::string{Spelling(this->my_operator)};
     }
-    std::string String() {
-        std::stringstream out;
-        out << '(' << this->my_operator << this->right->String() << ')';
-        return out.str();
+    std::string String() override {
+        return Print(this);
+    }
+
+    ~PrefixExpression() {
+        detail::Release(std::move(this->right));
     }
 
-    token::Token token;
-    std::string my_operator;
+    Operator my_operator{};
     std::shared_ptr<Expression> right;
 };
 
 struct InfixExpression : public Expression {
     std::string expressionNode() override { return ""; }
     std::string TokenLiteral() {
-        return this->token.literal;
+        return std::string{Spelling(this->my_operator)};
     }
-    std::string String() {
-        std::stringstream out;
-        out << '(' << this->left->String() << ' ' << this->my_operator << ' ' << this->right->String() << ')';
-        return out.str();
+    std::string String() override {
+        return Print(this);
+    }
+
+    ~InfixExpression() {
+        detail::Release(std::move(this->left));
+        detail::Release(std::move(this->right));
     }
 
-    token::Token token;
     std::shared_ptr<Expression> left;
-    std::string my_operator;
+    Operator my_operator{};
     std::shared_ptr<Expression> right;
 };
 
 struct Boolean : public Expression {
     std::string expressionNode() override { return ""; }
     std::string TokenLiteral() {
-        return this->token.literal;
+        return this->value ? "true" : "false";
     }
     std::string String() {
-        return this->token.literal;
+        return this->TokenLiteral();
     }
 
-    token::Token token;
     bool value{};
 };
 
 struct BlockStatement : public Statement {
     std::string statementNode() override { return ""; }
     std::string TokenLiteral() {
-        return this->token.literal;
+        return "{";
     }
     std::string String() override {
-        std::stringstream out;
-        for (const auto& statement : statements) {
-            out << statement->String();
+        return Print(this);
+    }
+
+    ~BlockStatement() {
+        for (auto& statement : this->statements) {
+            detail::Release(std::move(statement));
         }
-        return out.str();
     }
 
-    token::Token token;
     std::vector<std::shared_ptr<Statement>> statements;
 };
 
 struct IfExpression : public Expression {
     std::string expressionNode() override { return ""; }
     std::string TokenLiteral() {
-        return this->token.literal;
+        return "if";
     }
-    std::string String() {
-        std::stringstream out;
-        out << "if" << this->condition->String() << ' ' << this->consequence->String();
-        if (this->alternative.get()) {
-            out << "else " << this->alternative;
-        }
-        return out.str();
+    std::string String() override {
+        return Print(this);
+    }
+
+    ~IfExpression() {
+        detail::Release(std::move(this->condition));
+        detail::Release(std::move(this->consequence));
+        detail::Release(std::move(this->alternative));
     }
 
-    token::Token token;
     std::shared_ptr<Expression> condition;
     std::shared_ptr<BlockStatement> consequence;
     std::shared_ptr<BlockStatement> alternative;
@@ -213,40 +257,40 @@ struct IfExpression : public Expression {
 struct FunctionLteral : public Expression {
     std::string expressionNode() override { return ""; }
     std::string TokenLiteral() {
-        return this->token.literal;
+        return "fn";
     }
-    std::string String() {
-        std::stringstream out;
-        out << this->TokenLiteral() << '(';
-        for (const auto& one : parameters) {
-            out << one->String() << ", ";
-        }
-        out << ") ";
-        out << this->body->String();
-        return out.str();
+    std::string String() override {
+        return Print(this);
+    }
+
+    ~FunctionLteral() {
+        detail::Release(std::move(this->body));
     }
 
-    token::Token token;
     std::vector<std::shared_ptr<Identifier>> parameters;
     std::shared_ptr<BlockStatement> body;
+    // Where `fn` is in the source, so that profiles can point at the function;
+    // 0 when the lexer no longer knew.
+    uint32_t line{};
+    uint32_t column{};
 };
 
 struct CallExpression : public Expression {
     std::string expressionNode() override { return ""; }
     std::string TokenLiteral() {
-        return this->token.literal;
+        return "(";
     }
-    std::string String() {
-        std::stringstream out;
-        out << function->String() << '(';
-        for (uint32_t i = 0; i < arguments.size(); ++i) {
-            out << arguments[i]->String() << (i == arguments.size() - 1 ? "" : ", ");
+    std::string String() override {
+        return Print(this);
+    }
+
+    ~CallExpression() {
+        detail::Release(std::move(this->function));
+        for (auto& argument : this->arguments) {
+            detail::Release(std::move(argument));
         }
-        out << ')';
-        return out.str();
     }
 
-    token::Token token;
     std::shared_ptr<Expression> function;
     std::vector<std::shared_ptr<Expression>> arguments;
 };
@@ -0,0 +1,1387 @@
+#include "emitter.h"
+
+#include <algorithm>
+#include <set>
+#include <sstream>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <purity/purity.h>
+#include <resolver/resolver.h>
+#include <symbols/symbols.h>
+#include <types/types.h>
+
+namespace
+{
+
+constexpr std::string_view runtime = R"---(// Generated by monkey.exe emit-cpp. Do not edit.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#ifndef MONKEY_MEMO_LIMIT
+#define MONKEY_MEMO_LIMIT 65536
+#endif
+
+// A value crossing the C boundary of monkey_execute: type 0 is null,
+// 1 an integer, 2 a boolean (integer is 0 or 1) and 3 a function.
+struct monkey_value {
+    int type;
+    std::int64_t integer;
+};
+
+// Bounds one monkey_execute call; zero means unlimited. Fuel counts function
+// calls: Monkey has no loops, so any long computation is made of them. Memory
+// is in bytes of cells and closures (see monkey_rt::Heap).
+struct monkey_limits {
+    std::uint64_t fuel;
+    std::uint64_t timeout_ns;
+    std::uint64_t memory;
+};
+
+// Heap use of one monkey_execute call, in bytes: everything allocated, the
+// most live at once, and what was still live when it returned, after the
+// cells that reference cycles kept alive were emptied.
+struct monkey_usage {
+    std::uint64_t allocated;
+    std::uint64_t peak;
+    std::uint64_t live;
+};
+
+// The globals of a session (see monkey_piece): a cell per slot, made by the
+// first piece that runs with the slot, and the name of each.
+struct monkey_globals {
+    void** cells;
+    const char* const* names;
+    std::size_t count;
+};
+
+#ifndef MONKEY_TRACE_EVENTS
+#define MONKEY_TRACE_EVENTS 65536
+#endif
+
+#ifndef MONKEY_PROFILE_FRAMES
+#define MONKEY_PROFILE_FRAMES 1024
+#endif
+
+#ifndef MONKEY_MAX_DEPTH
+#define MONKEY_MAX_DEPTH 4000
+#endif
+
+namespace monkey_rt {
+
+struct Unset {};
+struct Null {};
+struct Value;
+
+struct Closure {
+    std::size_t arity;
+    std::function<Value(const std::vector<Value>&)> body;
+    std::size_t captured = 0; // bytes charged to the heap for the captures in body
+
+    ~Closure();
+};
+
+using Function = std::shared_ptr<const Closure>;
+
+struct Value {
+    std::variant<Unset, Null, std::int64_t, bool, Function> v;
+};
+
+using Cell = std::shared_ptr<Value>;
+
+struct Error : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+inline const char* typeName(const Value& value) {
+    switch (value.v.index()) {
+    case 2: return "INTEGER";
+    case 3: return "BOOLEAN";
+    case 4: return "FUNCTION";
+    default: return "NULL";
+    }
+}
+
+inline Value null() { return Value{Null{}}; }
+
+[[noreturn]] inline void fail(const std::string& message) { throw Error(message); }
+
+// Heap use of the execution running on this thread, in bytes. Only cells and
+// closures are counted, being what outlives the call that makes it; a closure
+// is charged its block and its captures.
+struct Heap {
+    std::uint64_t limit = 0; // 0 is unlimited
+    std::uint64_t live = 0;
+    std::uint64_t peak = 0;
+    std::uint64_t allocated = 0;
+
+    void reserve(std::size_t bytes) {
+        if (limit && live + bytes > limit) {
+            fail("out of memory");
+        }
+        live += bytes;
+        allocated += bytes;
+        peak = std::max(peak, live);
+    }
+
+    void release(std::size_t bytes) {
+        live -= std::min<std::uint64_t>(live, bytes);
+    }
+};
+
+constinit thread_local Heap heap;
+
+inline Closure::~Closure() { heap.release(captured); }
+
+// Allocates from the heap of the current execution.
+template <class T>
+struct Counted {
+    using value_type = T;
+
+    Counted() = default;
+    template <class U>
+    Counted(const Counted<U>&) {}
+
+    T* allocate(std::size_t n) {
+        heap.reserve(n * sizeof(T));
+        return std::allocator<T>{}.allocate(n);
+    }
+
+    void deallocate(T* p, std::size_t n) {
+        heap.release(n * sizeof(T));
+        std::allocator<T>{}.deallocate(p, n);
+    }
+
+    template <class U>
+    bool operator==(const Counted<U>&) const { return true; }
+};
+
+// The value of a cell, linked into the list of the live cells of its thread
+// so that the cycles an execution leaves behind can be broken when it ends.
+struct Slot : Value {
+    explicit Slot(Value value);
+    Slot(const Slot&) = delete;
+    Slot& operator=(const Slot&) = delete;
+    ~Slot();
+
+    Slot* prev;
+    Slot* next;
+};
+
+constinit thread_local Slot* cells = nullptr;
+
+inline Slot::Slot(Value value) : Value{std::move(value)}, prev{nullptr}, next{cells} {
+    if (next) {
+        next->prev = this;
+    }
+    cells = this;
+}
+
+inline Slot::~Slot() {
+    (prev ? prev->next : cells) = next;
+    if (next) {
+        next->prev = prev;
+    }
+}
+
+inline Cell cell(Value value = {}) {
+    return std::allocate_shared<Slot>(Counted<Slot>{}, std::move(value));
+}
+
+// Frees what reference cycles between closures and cells still hold once an
+// execution is over: moves every value out of the cells left, then drops the
+// values, which destroys the closures and with them the cells they capture.
+inline void sweep() {
+    std::vector<Value> values;
+    try {
+        for (auto slot = cells; slot; slot = slot->next) {
+            values.push_back(std::move(static_cast<Value&>(*slot)));
+        }
+    } catch (const std::bad_alloc&) {
+        // What was not moved out stays allocated.
+    }
+}
+
+// Empties cells when the scope that declared them ends. A closure stored in a
+// cell captures that same cell, so neither is freed until one lets go.
+template <class Empty>
+struct Release {
+    ~Release() { empty(); }
+
+    Empty empty;
+};
+
+// The cell of global slot `i` of a session, made on first use. It belongs to
+// the session rather than to the piece that made it; see monkey_release.
+inline const Cell& slot(monkey_globals* globals, std::size_t i) {
+    if (!globals->cells[i]) {
+        globals->cells[i] = new Cell(cell());
+    }
+    return *static_cast<const Cell*>(globals->cells[i]);
+}
+
+inline Value unbound(const char* name) { fail(std::string("identifier not found: ") + name); }
+
+inline const Value& load(const char* name, std::initializer_list<const Value*> scopes) {
+    for (const auto value : scopes) {
+        if (value->v.index() != 0) {
+            return *value;
+        }
+    }
+    fail(std::string("identifier not found: ") + name);
+}
+
+// A global of the session that no piece had declared when the reading one
+// was translated, looked up by name when the read runs.
+inline const Value& global(const monkey_globals* globals, const char* name) {
+    for (std::size_t i = 0; i < globals->count; ++i) {
+        if (globals->cells[i] && std::strcmp(globals->names[i], name) == 0) {
+            const auto& value = **static_cast<const Cell*>(globals->cells[i]);
+            if (value.v.index() != 0) {
+                return value;
+            }
+            break;
+        }
+    }
+    fail(std::string("identifier not found: ") + name);
+}
+
+inline const Value& load(const char* name, std::initializer_list<const Value*> scopes,
+                         const monkey_globals* globals) {
+    for (const auto value : scopes) {
+        if (value->v.index() != 0) {
+            return *value;
+        }
+    }
+    return global(globals, name);
+}
+
+inline bool truthy(const Value& value) {
+    if (const auto b = std::get_if<bool>(&value.v)) {
+        return *b;
+    }
+    return value.v.index() != 1;
+}
+
+[[noreturn]] inline void overflow() { fail("integer overflow"); }
+
+inline bool same(const Value& l, const Value& r) {
+    if (l.v.index() != r.v.index()) {
+        return false;
+    }
+    switch (l.v.index()) {
+    case 2: return std::get<2>(l.v) == std::get<2>(r.v);
+    case 3: return std::get<3>(l.v) == std::get<3>(r.v);
+    case 4: return std::get<4>(l.v) == std::get<4>(r.v);
+    default: return true;
+    }
+}
+
+// An infix operator applied to anything but two integers.
+[[gnu::cold]] inline Value mixed(const std::string& o, const Value& l, const Value& r) {
+    if (o == "==") return Value{same(l, r)};
+    if (o == "!=") return Value{!same(l, r)};
+    if (l.v.index() != r.v.index()) {
+        fail(std::string("type mismatch: ") + typeName(l) + ' ' + o + ' ' + typeName(r));
+    }
+    fail(std::string("unknown operator: ") + typeName(l) + ' ' + o + ' ' + typeName(r));
+}
+
+// The integer operators below are emitted where types::Infer proves both
+// operands integers; they still check, falling back to mixed() if not.
+inline bool integers(const Value& l, const Value& r) {
+    return l.v.index() == 2 && r.v.index() == 2;
+}
+
+inline Value iadd(const Value& l, const Value& r) {
+    if (!integers(l, r)) [[unlikely]] {
+        return mixed("+", l, r);
+    }
+    std::int64_t result;
+    if (__builtin_add_overflow(*std::get_if<2>(&l.v), *std::get_if<2>(&r.v), &result)) {
+        overflow();
+    }
+    return Value{result};
+}
+inline Value isub(const Value& l, const Value& r) {
+    if (!integers(l, r)) [[unlikely]] {
+        return mixed("-", l, r);
+    }
+    std::int64_t result;
+    if (__builtin_sub_overflow(*std::get_if<2>(&l.v), *std::get_if<2>(&r.v), &result)) {
+        overflow();
+    }
+    return Value{result};
+}
+inline Value imul(const Value& l, const Value& r) {
+    if (!integers(l, r)) [[unlikely]] {
+        return mixed("*", l, r);
+    }
+    std::int64_t result;
+    if (__builtin_mul_overflow(*std::get_if<2>(&l.v), *std::get_if<2>(&r.v), &result)) {
+        overflow();
+    }
+    return Value{result};
+}
+inline Value idiv(const Value& l, const Value& r) {
+    if (!integers(l, r)) [[unlikely]] {
+        return mixed("/", l, r);
+    }
+    const auto a = *std::get_if<2>(&l.v);
+    const auto b = *std::get_if<2>(&r.v);
+    if (b == 0) {
+        fail("division by zero");
+    }
+    if (a == INT64_MIN && b == -1) {
+        overflow();
+    }
+    return Value{a / b};
+}
+inline Value ilt(const Value& l, const Value& r) {
+    if (!integers(l, r)) [[unlikely]] {
+        return mixed("<", l, r);
+    }
+    return Value{*std::get_if<2>(&l.v) < *std::get_if<2>(&r.v)};
+}
+inline Value igt(const Value& l, const Value& r) {
+    if (!integers(l, r)) [[unlikely]] {
+        return mixed(">", l, r);
+    }
+    return Value{*std::get_if<2>(&l.v) > *std::get_if<2>(&r.v)};
+}
+inline Value ieq(const Value& l, const Value& r) {
+    if (!integers(l, r)) [[unlikely]] {
+        return mixed("==", l, r);
+    }
+    return Value{*std::get_if<2>(&l.v) == *std::get_if<2>(&r.v)};
+}
+inline Value ine(const Value& l, const Value& r) {
+    if (!integers(l, r)) [[unlikely]] {
+        return mixed("!=", l, r);
+    }
+    return Value{*std::get_if<2>(&l.v) != *std::get_if<2>(&r.v)};
+}
+
+inline Value infix(const char* op, const Value& l, const Value& r) {
+    const std::string o = op;
+    if (integers(l, r)) {
+        if (o == "+") return iadd(l, r);
+        if (o == "-") return isub(l, r);
+        if (o == "*") return imul(l, r);
+        if (o == "/") return idiv(l, r);
+        if (o == "<") return ilt(l, r);
+        if (o == ">") return igt(l, r);
+        if (o == "==") return ieq(l, r);
+        if (o == "!=") return ine(l, r);
+    }
+    return mixed(o, l, r);
+}
+
+inline Value bang(const Value& value) {
+    return Value{!truthy(value)};
+}
+
+inline Value negate(const Value& value) {
+    if (value.v.index() != 2) {
+        fail(std::string("unknown operator: -") + typeName(value));
+    }
+    return isub(Value{std::int64_t{0}}, value);
+}
+
+template <class Body>
+inline Value function(std::size_t arity, Body body) {
+    auto closure = std::allocate_shared<Closure>(Counted<Closure>{}, arity, std::move(body));
+    heap.reserve(sizeof(Body));
+    closure->captured = sizeof(Body);
+    return Value{Function{std::move(closure)}};
+}
+
+// What the execution running on this thread may still spend. Calls count
+// down `left`; only when it runs out is the rest of the budget consulted, and
+// with a deadline that happens every 1024 calls, so a run that overstays it
+// ends at most that many calls later.
+struct Budget {
+    std::uint64_t left = 0;
+    std::uint64_t fuel = UINT64_MAX;
+    bool timed = false;
+    std::chrono::steady_clock::time_point deadline;
+
+    static Budget of(const monkey_limits* limits) {
+        Budget budget;
+        if (limits && limits->fuel) {
+            budget.fuel = limits->fuel;
+        }
+        if (limits && limits->timeout_ns) {
+            budget.timed = true;
+            budget.deadline = std::chrono::steady_clock::now() + std::chrono::nanoseconds(limits->timeout_ns);
+        }
+        return budget;
+    }
+
+    [[gnu::noinline, gnu::cold]] void refill() {
+        if (fuel == 0) {
+            fail("fuel exhausted");
+        }
+        if (timed && std::chrono::steady_clock::now() > deadline) {
+            fail("timeout");
+        }
+        left = timed ? std::min<std::uint64_t>(fuel, 1024) : fuel;
+        fuel -= left;
+    }
+};
+
+constinit thread_local Budget budget;
+
+inline void charge() {
+    if (budget.left == 0) {
+        budget.refill();
+    }
+    --budget.left;
+}
+
+// Calls in progress on this thread. Each one takes up to about a kilobyte of
+// native stack, so recursion deeper than MONKEY_MAX_DEPTH ends with an error
+// rather than by overflowing an 8 MB thread stack.
+// Inline, so that all units loaded into the process share it: the pieces of
+// a session call into each other.
+inline constinit thread_local std::uint32_t depth = 0;
+
+struct Nested {
+    Nested() {
+        if (++depth > MONKEY_MAX_DEPTH) {
+            --depth;
+            fail("stack overflow");
+        }
+    }
+    Nested(const Nested&) = delete;
+    Nested& operator=(const Nested&) = delete;
+    ~Nested() { --depth; }
+};
+
+inline Value call(const Value& callee, const std::vector<Value>& arguments) {
+    charge();
+    const Nested nested;
+    const auto closure = std::get_if<Function>(&callee.v);
+    if (!closure) {
+        fail(std::string("not a function: ") + typeName(callee));
+    }
+    if ((*closure)->arity != arguments.size()) {
+        fail("wrong number of arguments: want=" + std::to_string((*closure)->arity) +
+            ", got=" + std::to_string(arguments.size()));
+    }
+    return (*closure)->body(arguments);
+}
+
+struct MemoStats {
+    const char* name;
+    std::uint64_t calls{};
+    std::uint64_t hits{};
+    std::uint64_t entries{};
+};
+
+// The tables of the last run on this thread; monkey_program starts afresh.
+inline std::vector<std::shared_ptr<MemoStats>>& memoTables() {
+    thread_local std::vector<std::shared_ptr<MemoStats>> tables;
+    return tables;
+}
+
+struct KeyHash {
+    std::size_t operator()(const std::vector<std::int64_t>& key) const {
+        std::size_t hash = key.size();
+        for (const auto part : key) {
+            hash = hash * 1000003 ^ std::hash<std::int64_t>{}(part);
+        }
+        return hash;
+    }
+};
+
+// Caches results by argument value. Calls with anything but integers and
+// booleans bypass the cache.
+inline Value memoize(const char* name, const Value& function) {
+    const auto inner = std::get<Function>(function.v);
+    const auto stats = memoTables().emplace_back(std::make_shared<MemoStats>(MemoStats{name}));
+    const auto cache = std::make_shared<std::unordered_map<std::vector<std::int64_t>, Value, KeyHash>>();
+    return monkey_rt::function(inner->arity, [inner, stats, cache](const std::vector<Value>& args) -> Value {
+        ++stats->calls;
+        std::vector<std::int64_t> key;
+        key.reserve(args.size() * 2);
+        for (const auto& arg : args) {
+            if (arg.v.index() == 2) {
+                key.push_back(2);
+                key.push_back(std::get<2>(arg.v));
+            } else if (arg.v.index() == 3) {
+                key.push_back(3);
+                key.push_back(std::get<3>(arg.v));
+            } else {
+                return inner->body(args);
+            }
+        }
+        if (const auto it = cache->find(key); it != cache->end()) {
+            ++stats->hits;
+            return it->second;
+        }
+        auto result = inner->body(args);
+        if (cache->size() < MONKEY_MEMO_LIMIT) {
+            cache->emplace(std::move(key), result);
+            stats->entries = cache->size();
+        }
+        return result;
+    });
+}
+
+inline std::string memoReport() {
+    std::string report;
+    for (const auto& stats : memoTables()) {
+        char line[256];
+        std::snprintf(line, sizeof(line), "%s: %llu calls, %llu hits (%.1f%%), %llu entries\n", stats->name,
+            static_cast<unsigned long long>(stats->calls), static_cast<unsigned long long>(stats->hits),
+            stats->calls ? 100.0 * stats->hits / stats->calls : 0.0, static_cast<unsigned long long>(stats->entries));
+        report += line;
+    }
+    return report;
+}
+
+struct TraceEvent {
+    const char* name;
+    std::int64_t start;
+    std::int64_t end;
+};
+
+// Written only by its own thread; `next` counts every span ever recorded.
+struct TraceRing {
+    std::vector<TraceEvent> events = std::vector<TraceEvent>(MONKEY_TRACE_EVENTS);
+    std::atomic<std::uint64_t> next{0};
+    std::size_t thread{};
+};
+
+inline std::int64_t traceClock() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Spans are only recorded when the program runs with MONKEY_TRACE=<file>, and
+// are written there as Chrome trace-event JSON when the program exits.
+struct Tracer {
+    const char* path = std::getenv("MONKEY_TRACE");
+    std::int64_t origin = traceClock();
+    std::mutex mutex;
+    std::vector<std::shared_ptr<TraceRing>> rings;
+
+    ~Tracer() {
+        if (!path) {
+            return;
+        }
+        std::FILE* out = std::fopen(path, "w");
+        if (!out) {
+            std::fprintf(stderr, "cannot write trace to %s\n", path);
+            return;
+        }
+        std::fputs("{\"traceEvents\": [", out);
+        const char* separator = "";
+        for (const auto& ring : rings) {
+            const auto next = ring->next.load(std::memory_order_acquire);
+            const std::uint64_t size = ring->events.size();
+            for (auto i = next > size ? next - size : 0; i < next; ++i) {
+                const auto& event = ring->events[i % size];
+                std::fprintf(out, "%s\n{\"name\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %zu}",
+                    separator, event.name, (event.start - origin) / 1000.0, (event.end - event.start) / 1000.0, ring->thread);
+                separator = ",";
+            }
+        }
+        std::fputs("\n]}\n", out);
+        std::fclose(out);
+    }
+};
+
+inline Tracer& tracer() {
+    static Tracer instance;
+    return instance;
+}
+
+// The calling thread's ring, registered on first use; recording never locks.
+inline TraceRing& traceRing() {
+    thread_local const std::shared_ptr<TraceRing> ring = [] {
+        auto& t = tracer();
+        const std::lock_guard lock{t.mutex};
+        auto created = std::make_shared<TraceRing>();
+        created->thread = t.rings.size() + 1;
+        t.rings.push_back(created);
+        return created;
+    }();
+    return *ring;
+}
+
+// Records the lifetime of a call as a span; the last MONKEY_TRACE_EVENTS
+// spans of each thread are kept.
+struct Span {
+    explicit Span(const char* name) : name{tracer().path ? name : nullptr}, start{this->name ? traceClock() : 0} {}
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+    ~Span() {
+        if (!name) {
+            return;
+        }
+        auto& ring = traceRing();
+        const auto next = ring.next.load(std::memory_order_relaxed);
+        ring.events[next % ring.events.size()] = TraceEvent{name, start, traceClock()};
+        ring.next.store(next + 1, std::memory_order_release);
+    }
+
+    const char* name;
+    std::int64_t start;
+};
+
+// A thread's call stack as the profiler sees it. Frame pushes and pops
+// names; the sampling thread reads them without locking. Frames deeper than
+// MONKEY_PROFILE_FRAMES are counted but not recorded.
+struct ProfileStack {
+    std::atomic<const char*> frames[MONKEY_PROFILE_FRAMES]{};
+    std::atomic<std::size_t> depth{0};
+};
+
+// With MONKEY_PROFILE=<file>, a thread samples the call stack of every
+// thread running the program MONKEY_PROFILE_HZ times a second (1000 by
+// default) and at exit writes the samples to <file> as folded stacks,
+// "program;fib:1:11;fib:1:11 42" per line, for flamegraph.pl or speedscope.
+// A host such as the REPL may instead sample between start() and stop().
+struct Profiler {
+    const char* path = std::getenv("MONKEY_PROFILE");
+    std::atomic<bool> on{false}; // whether frames are pushed
+    std::atomic<bool> done{false};
+    std::mutex mutex; // guards stacks
+    std::vector<std::shared_ptr<ProfileStack>> stacks;
+    std::map<std::string, std::uint64_t> samples;
+    std::thread sampler;
+
+    Profiler() {
+        if (path) {
+            start();
+        }
+    }
+
+    void start() {
+        if (on.exchange(true)) {
+            return;
+        }
+        done = false;
+        const char* hz = std::getenv("MONKEY_PROFILE_HZ");
+        const auto rate = std::max(1L, hz ? std::atol(hz) : 1000L);
+        sampler = std::thread([this, interval = std::chrono::microseconds(1000000 / rate)] {
+            std::string folded;
+            std::vector<std::shared_ptr<ProfileStack>> sampled;
+            while (!done.load()) {
+                std::this_thread::sleep_for(interval);
+                {
+                    const std::lock_guard lock{mutex};
+                    sampled = stacks;
+                }
+                for (const auto& stack : sampled) {
+                    const auto depth = std::min<std::size_t>(stack->depth.load(std::memory_order_acquire), MONKEY_PROFILE_FRAMES);
+                    if (depth == 0) {
+                        continue;
+                    }
+                    folded.clear();
+                    for (std::size_t i = 0; i < depth; ++i) {
+                        folded += i > 0 ? ";" : "";
+                        folded += stack->frames[i].load(std::memory_order_relaxed);
+                    }
+                    ++samples[folded];
+                }
+            }
+        });
+    }
+
+    // Joins the sampler; `samples` holds what it took.
+    void stop() {
+        if (!on.exchange(false)) {
+            return;
+        }
+        done = true;
+        sampler.join();
+    }
+
+    ~Profiler() {
+        if (!path) {
+            return;
+        }
+        stop();
+        std::FILE* out = std::fopen(path, "w");
+        if (!out) {
+            std::fprintf(stderr, "cannot write profile to %s\n", path);
+            return;
+        }
+        for (const auto& [stack, count] : samples) {
+            std::fprintf(out, "%s %llu\n", stack.c_str(), static_cast<unsigned long long>(count));
+        }
+        std::fclose(out);
+    }
+};
+
+inline Profiler& profiler() {
+    static Profiler instance;
+    return instance;
+}
+
+// The calling thread's stack, registered with the profiler on first use.
+inline ProfileStack& profileStack() {
+    thread_local const std::shared_ptr<ProfileStack> stack = [] {
+        auto& p = profiler();
+        auto created = std::make_shared<ProfileStack>();
+        const std::lock_guard lock{p.mutex};
+        p.stacks.push_back(created);
+        return created;
+    }();
+    return *stack;
+}
+
+// Keeps a call on its thread's profiled stack for its lifetime.
+struct Frame {
+    explicit Frame(const char* name) : active{profiler().on.load(std::memory_order_relaxed)} {
+        if (!active) {
+            return;
+        }
+        auto& stack = profileStack();
+        const auto depth = stack.depth.load(std::memory_order_relaxed);
+        if (depth < MONKEY_PROFILE_FRAMES) {
+            stack.frames[depth].store(name, std::memory_order_relaxed);
+        }
+        stack.depth.store(depth + 1, std::memory_order_release);
+    }
+    Frame(const Frame&) = delete;
+    Frame& operator=(const Frame&) = delete;
+
+    ~Frame() {
+        if (active) {
+            auto& stack = profileStack();
+            stack.depth.store(stack.depth.load(std::memory_order_relaxed) - 1, std::memory_order_release);
+        }
+    }
+
+    bool active;
+};
+
+inline Value fromHost(const monkey_value& value) {
+    switch (value.type) {
+    case 1: return Value{value.integer};
+    case 2: return Value{value.integer != 0};
+    default: return null();
+    }
+}
+
+inline monkey_value toHost(const Value& value) {
+    switch (value.v.index()) {
+    case 2: return {1, std::get<2>(value.v)};
+    case 3: return {2, std::get<3>(value.v)};
+    case 4: return {3, 0};
+    default: return {0, 0};
+    }
+}
+
+inline std::string inspect(const Value& value) {
+    switch (value.v.index()) {
+    case 2: return std::to_string(std::get<2>(value.v));
+    case 3: return std::get<3>(value.v) ? "true" : "false";
+    case 4: return "fn";
+    default: return "null";
+    }
+}
+
+} // namespace monkey_rt
+
+)---";
+
+constexpr std::string_view entryPoints = R"---(
+extern "C" int monkey_execute(const monkey_value* inputs, const monkey_limits* limits, monkey_value* result,
+                              monkey_usage* usage, char* error, std::size_t size) {
+    monkey_rt::budget = monkey_rt::Budget::of(limits);
+    monkey_rt::heap = {limits ? limits->memory : 0};
+    auto status = 0;
+    try {
+        *result = monkey_rt::toHost(monkey_program(inputs));
+    } catch (const std::bad_alloc&) {
+        std::snprintf(error, size, "out of memory");
+        status = 1;
+    } catch (const std::exception& e) {
+        std::snprintf(error, size, "%s", e.what());
+        status = 1;
+    }
+    monkey_rt::sweep();
+    if (usage) {
+        *usage = {monkey_rt::heap.allocated, monkey_rt::heap.peak, monkey_rt::heap.live};
+    }
+    return status;
+}
+
+extern "C" const char* monkey_run() {
+    static std::string result;
+    monkey_rt::budget = {};
+    monkey_rt::heap = {};
+    try {
+        result = monkey_rt::inspect(monkey_program());
+    } catch (const monkey_rt::Error& error) {
+        result = std::string("ERROR: ") + error.what();
+    } catch (const std::bad_alloc&) {
+        result = "ERROR: out of memory";
+    }
+    monkey_rt::sweep();
+    return result.c_str();
+}
+
+extern "C" const char* monkey_memo_stats() {
+    static std::string report;
+    report = monkey_rt::memoReport();
+    return report.c_str();
+}
+
+#ifdef MONKEY_MAIN
+int main() {
+    std::puts(monkey_run());
+    std::fputs(monkey_memo_stats(), stderr);
+}
+#endif
+)---";
+
+constexpr std::string_view pieceEntryPoints = R"---(
+extern "C" int monkey_piece(monkey_globals* globals, monkey_value* result, char* error, std::size_t size) {
+    monkey_rt::budget = {};
+    monkey_rt::heap = {};
+    try {
+        *result = monkey_rt::toHost(monkey_program(globals));
+        return 0;
+    } catch (const std::bad_alloc&) {
+        std::snprintf(error, size, "out of memory");
+    } catch (const std::exception& e) {
+        std::snprintf(error, size, "%s", e.what());
+    }
+    return 1;
+}
+
+// Samples the session's calls until monkey_profile_stop, which passes each
+// folded stack and its count to `report`. Every piece shares one profiler;
+// under MONKEY_PROFILE the samples go to its file instead.
+extern "C" void monkey_profile_start() {
+    auto& profiler = monkey_rt::profiler();
+    if (!profiler.path) {
+        profiler.start();
+    }
+}
+
+extern "C" void monkey_profile_stop(void (*report)(const char* stack, std::uint64_t count, void* context),
+                                    void* context) {
+    auto& profiler = monkey_rt::profiler();
+    if (profiler.path) {
+        return;
+    }
+    profiler.stop();
+    for (const auto& [stack, count] : profiler.samples) {
+        report(stack.c_str(), count, context);
+    }
+    profiler.samples.clear();
+}
+
+extern "C" void monkey_release(monkey_globals* globals) {
+    for (std::size_t i = 0; i < globals->count; ++i) {
+        if (globals->cells[i]) {
+            **static_cast<monkey_rt::Cell*>(globals->cells[i]) = {};
+        }
+    }
+    for (std::size_t i = 0; i < globals->count; ++i) {
+        delete static_cast<monkey_rt::Cell*>(globals->cells[i]);
+        globals->cells[i] = nullptr;
+    }
+}
+)---";
+
+// Names bound in a function body (or at top level), not counting nested functions.
+void collectLets(const ast::BlockStatement* block, std::set<symbols::Symbol>& names);
+
+void collectLets(const std::vector<std::shared_ptr<ast::Statement>>& statements, std::set<symbols::Symbol>& names);
+
+void collectLets(const ast::Expression* expression, std::set<symbols::Symbol>& names) {
+    if (const auto prefix = dynamic_cast<const ast::PrefixExpression*>(expression)) {
+        collectLets(prefix->right.get(), names);
+    } else if (const auto infix = dynamic_cast<const ast::InfixExpression*>(expression)) {
+        collectLets(infix->left.get(), names);
+        collectLets(infix->right.get(), names);
+    } else if (const auto ifExp = dynamic_cast<const ast::IfExpression*>(expression)) {
+        collectLets(ifExp->condition.get(), names);
+        collectLets(ifExp->consequence.get(), names);
+        collectLets(ifExp->alternative.get(), names);
+    } else if (const auto call = dynamic_cast<const ast::CallExpression*>(expression)) {
+        collectLets(call->function.get(), names);
+        for (const auto& argument : call->arguments) {
+            collectLets(argument.get(), names);
+        }
+    }
+}
+
+void collectLets(const std::vector<std::shared_ptr<ast::Statement>>& statements, std::set<symbols::Symbol>& names) {
+    for (const auto& statement : statements) {
+        if (const auto let = dynamic_cast<const ast::LetStatement*>(statement.get())) {
+            names.insert(let->name.symbol);
+            collectLets(let->value.get(), names);
+        } else if (const auto ret = dynamic_cast<const ast::ReturnStatement*>(statement.get())) {
+            collectLets(ret->returnValue.get(), names);
+        } else if (const auto exp = dynamic_cast<const ast::ExpressionStatement*>(statement.get())) {
+            collectLets(exp->expression.get(), names);
+        }
+    }
+}
+
+void collectLets(const ast::BlockStatement* block, std::set<symbols::Symbol>& names) {
+    if (block) {
+        collectLets(block->statements, names);
+    }
+}
+
+// Every identifier read anywhere inside nested function literals.
+void collectInnerReads(const ast::Node* node, bool inner, std::set<symbols::Symbol>& names) {
+    if (!node) {
+        return;
+    }
+    if (const auto identifier = dynamic_cast<const ast::Identifier*>(node)) {
+        if (inner) {
+            names.insert(identifier->symbol);
+        }
+    } else if (const auto let = dynamic_cast<const ast::LetStatement*>(node)) {
+        collectInnerReads(let->value.get(), inner, names);
+    } else if (const auto ret = dynamic_cast<const ast::ReturnStatement*>(node)) {
+        collectInnerReads(ret->returnValue.get(), inner, names);
+    } else if (const auto exp = dynamic_cast<const ast::ExpressionStatement*>(node)) {
+        collectInnerReads(exp->expression.get(), inner, names);
+    } else if (const auto block = dynamic_cast<const ast::BlockStatement*>(node)) {
+        for (const auto& statement : block->statements) {
+            collectInnerReads(statement.get(), inner, names);
+        }
+    } else if (const auto prefix = dynamic_cast<const ast::PrefixExpression*>(node)) {
+        collectInnerReads(prefix->right.get(), inner, names);
+    } else if (const auto infix = dynamic_cast<const ast::InfixExpression*>(node)) {
+        collectInnerReads(infix->left.get(), inner, names);
+        collectInnerReads(infix->right.get(), inner, names);
+    } else if (const auto ifExp = dynamic_cast<const ast::IfExpression*>(node)) {
+        collectInnerReads(ifExp->condition.get(), inner, names);
+        collectInnerReads(ifExp->consequence.get(), inner, names);
+        collectInnerReads(ifExp->alternative.get(), inner, names);
+    } else if (const auto literal = dynamic_cast<const ast::FunctionLteral*>(node)) {
+        collectInnerReads(literal->body.get(), true, names);
+    } else if (const auto call = dynamic_cast<const ast::CallExpression*>(node)) {
+        collectInnerReads(call->function.get(), inner, names);
+        for (const auto& argument : call->arguments) {
+            collectInnerReads(argument.get(), inner, names);
+        }
+    }
+}
+
+class Emitter
+{
+public:
+    Emitter(const resolver::Resolution& resolution, const types::Inference& inference, const purity::Analysis* purity,
+            const emitter::Options& options) :
+        m_resolution{resolution},
+        m_inference{inference},
+        m_purity{purity},
+        m_trace{options.trace},
+        m_profile{options.profile},
+        m_inputs{intern(options.inputs)},
+        m_piece{options.piece},
+        m_globals{intern(options.globals)}
+    {}
+
+    std::string Run(const ast::Program& program) {
+        m_out << runtime;
+        if (m_piece) {
+            m_out << "monkey_rt::Value monkey_program(monkey_globals* globals) {\n";
+        } else {
+            m_out << "monkey_rt::Value monkey_program(const monkey_value* inputs = nullptr) {\n";
+        }
+        m_indent = 1;
+        this->line(m_piece ? "static_cast<void>(globals);" : "static_cast<void>(inputs);");
+        if (m_trace) {
+            this->line("const monkey_rt::Span span{\"program\"};");
+        }
+        if (m_profile) {
+            this->line("const monkey_rt::Frame frame{\"program\"};");
+        }
+        if (m_purity) {
+            this->line("monkey_rt::memoTables().clear();");
+        }
+
+        std::set<symbols::Symbol> names{m_inputs.begin(), m_inputs.end()};
+        collectLets(program.statements, names);
+        std::set<symbols::Symbol> captured;
+        for (const auto& statement : program.statements) {
+            collectInnerReads(statement.get(), false, captured);
+        }
+        if (m_piece) {
+            // The cells of a session's globals outlive each of its pieces.
+            auto& scope = m_scopes.emplace_back();
+            for (std::size_t i = 0; i < m_globals.size(); ++i) {
+                const std::string name{symbols::Name(m_globals[i])};
+                this->line("const auto& c_" + name + "_0 = monkey_rt::slot(globals, " + std::to_string(i) + ");");
+                scope[m_globals[i]] = Variable{"(*c_" + name + "_0)"};
+            }
+            const auto value = this->statements(program.statements);
+            this->line("return " + value + ";");
+            m_scopes.pop_back();
+            m_out << "}\n" << pieceEntryPoints;
+            return m_out.str();
+        }
+
+        // Globals are always cells: functions declared earlier may read them.
+        this->openScope(names, {}, names);
+        if (!m_inputs.empty()) {
+            this->line("if (inputs) {");
+            for (std::size_t i = 0; i < m_inputs.size(); ++i) {
+                this->line("    " + m_scopes.back().at(m_inputs[i]).name + " = monkey_rt::fromHost(inputs[" +
+                           std::to_string(i) + "]);");
+            }
+            this->line("}");
+        }
+        this->release({names.begin(), names.end()});
+
+        const auto value = this->statements(program.statements);
+        this->line("return " + value + ";");
+        m_scopes.pop_back();
+
+        m_out << "}\n" << entryPoints;
+        return m_out.str();
+    }
+
+private:
+    struct Variable {
+        std::string name; // C++ expression naming the Value
+        bool parameter{};
+    };
+
+    using Scope = std::unordered_map<symbols::Symbol, Variable>;
+
+    static std::vector<symbols::Symbol> intern(const std::vector<std::string>& names) {
+        std::vector<symbols::Symbol> symbols;
+        for (const auto& name : names) {
+            symbols.push_back(symbols::Intern(name));
+        }
+        return symbols;
+    }
+
+    void line(const std::string& text) {
+        m_out << std::string(m_indent * 4, ' ') << text << '\n';
+    }
+
+    std::string temp() {
+        return "t" + std::to_string(m_temps++);
+    }
+
+    // Declares the variables of a new function scope. Parameters are bound
+    // from `args`; lets start Unset so that reads fall through to outer scopes.
+    void openScope(const std::set<symbols::Symbol>& lets, const std::vector<symbols::Symbol>& parameters,
+                   const std::set<symbols::Symbol>& captured) {
+        const auto depth = std::to_string(m_scopes.size());
+        auto& scope = m_scopes.emplace_back();
+        for (std::size_t i = 0; i < parameters.size(); ++i) {
+            const auto symbol = parameters[i];
+            const std::string name{symbols::Name(symbol)};
+            const auto argument = "args[" + std::to_string(i) + "]";
+            if (scope.contains(symbol)) {
+                this->line(scope[symbol].name + " = " + argument + ";");
+                continue;
+            }
+            if (captured.contains(symbol)) {
+                this->line("const auto c_" + name + '_' + depth + " = monkey_rt::cell(" + argument + ");");
+                scope[symbol] = Variable{"(*c_" + name + '_' + depth + ")", true};
+            } else {
+                this->line("monkey_rt::Value v_" + name + '_' + depth + " = " + argument + ";");
+                scope[symbol] = Variable{"v_" + name + '_' + depth, true};
+            }
+        }
+        for (const auto symbol : lets) {
+            if (scope.contains(symbol)) {
+                continue;
+            }
+            const std::string name{symbols::Name(symbol)};
+            if (captured.contains(symbol)) {
+                this->line("const auto c_" + name + '_' + depth + " = monkey_rt::cell();");
+                scope[symbol] = Variable{"(*c_" + name + '_' + depth + ")"};
+            } else {
+                this->line("monkey_rt::Value v_" + name + '_' + depth + ";");
+                scope[symbol] = Variable{"v_" + name + '_' + depth};
+            }
+        }
+    }
+
+    // Empties the cells of `names` in the current scope when it ends, which
+    // breaks the cycles between them and the closures stored in them.
+    void release(const std::vector<symbols::Symbol>& names) {
+        if (names.empty()) {
+            return;
+        }
+        std::string empty = "const monkey_rt::Release release{[&] {";
+        for (const auto name : names) {
+            empty += ' ' + m_scopes.back().at(name).name + " = {};";
+        }
+        this->line(empty + " }};");
+    }
+
+    // Emits the statements and returns the C++ expression holding their value.
+    std::string statements(const std::vector<std::shared_ptr<ast::Statement>>& statements) {
+        std::string value = "monkey_rt::null()";
+        for (const auto& statement : statements) {
+            value = this->statement(statement.get());
+        }
+        return value;
+    }
+
+    std::string statement(const ast::Statement* statement) {
+        if (const auto let = dynamic_cast<const ast::LetStatement*>(statement)) {
+            const auto literal = dynamic_cast<const ast::FunctionLteral*>(let->value.get());
+            if (literal) {
+                m_functionName = &let->name;
+            }
+            auto value = this->expression(let->value.get());
+            if (m_purity && literal && m_purity->Memoizable(literal)) {
+                value = "monkey_rt::memoize(\"" + std::string{let->name.value} + "\", " + value + ")";
+            }
+            this->line(m_scopes.back().at(let->name.symbol).name + " = " + value + ";");
+        } else if (const auto ret = dynamic_cast<const ast::ReturnStatement*>(statement)) {
+            this->line("return " + this->expression(ret->returnValue.get()) + ";");
+        } else if (const auto exp = dynamic_cast<const ast::ExpressionStatement*>(statement)) {
+            return this->value(exp->expression.get());
+        }
+        return "monkey_rt::null()";
+    }
+
+    std::string load(const ast::Identifier* identifier) {
+        std::vector<const Variable*> candidates;
+        for (auto scope = m_scopes.rbegin(); scope != m_scopes.rend(); ++scope) {
+            if (const auto it = scope->find(identifier->symbol); it != scope->end()) {
+                candidates.push_back(&it->second);
+            }
+        }
+        const std::string name{identifier->value};
+        // A piece may read globals that only later pieces declare.
+        const auto later = m_piece && !m_scopes.front().contains(identifier->symbol);
+        if (candidates.empty()) {
+            return later ? "monkey_rt::global(globals, \"" + name + "\")" : "monkey_rt::unbound(\"" + name + "\")";
+        }
+        if (candidates.front()->parameter) {
+            return candidates.front()->name;
+        }
+        std::string scopes;
+        for (const auto candidate : candidates) {
+            scopes += (scopes.empty() ? "&" : ", &") + candidate->name;
+        }
+        return "monkey_rt::load(\"" + name + "\", {" + scopes + (later ? "}, globals)" : "})");
+    }
+
+    // Emits whatever statements the expression needs and returns a C++
+    // expression for its value. Every operand is first stored in a temporary
+    // so evaluation order matches the source.
+    std::string expression(const ast::Expression* expression) {
+        if (!expression) {
+            return "monkey_rt::null()";
+        }
+        if (const auto integer = dynamic_cast<const ast::IntegerLiteral*>(expression)) {
+            return "monkey_rt::Value{std::int64_t{" + std::to_string(integer->value) + "}}";
+        }
+        if (const auto boolean = dynamic_cast<const ast::Boolean*>(expression)) {
+            return boolean->value ? "monkey_rt::Value{true}" : "monkey_rt::Value{false}";
+        }
+        if (const auto identifier = dynamic_cast<const ast::Identifier*>(expression)) {
+            return this->load(identifier);
+        }
+        if (const auto prefix = dynamic_cast<const ast::PrefixExpression*>(expression)) {
+            const auto right = this->value(prefix->right.get());
+            return (prefix->my_operator == ast::Operator::Bang ? "monkey_rt::bang(" : "monkey_rt::negate(") + right + ")";
+        }
+        if (const auto infix = dynamic_cast<const ast::InfixExpression*>(expression)) {
+            return this->infix(infix);
+        }
+        if (const auto ifExp = dynamic_cast<const ast::IfExpression*>(expression)) {
+            return this->ifExpression(ifExp);
+        }
+        if (const auto literal = dynamic_cast<const ast::FunctionLteral*>(expression)) {
+            return this->function(literal);
+        }
+        if (const auto call = dynamic_cast<const ast::CallExpression*>(expression)) {
+            const auto callee = this->value(call->function.get());
+            std::string arguments;
+            for (const auto& argument : call->arguments) {
+                arguments += (arguments.empty() ? "" : ", ") + this->value(argument.get());
+            }
+            return "monkey_rt::call(" + callee + ", {" + arguments + "})";
+        }
+        return "monkey_rt::null()";
+    }
+
+    // Like expression(), but pins the value in a temporary.
+    std::string value(const ast::Expression* expression) {
+        const auto value = this->expression(expression);
+        const auto name = this->temp();
+        this->line("const monkey_rt::Value " + name + " = " + value + ";");
+        return name;
+    }
+
+    std::string infix(const ast::InfixExpression* infix) {
+        const auto left = this->value(infix->left.get());
+        const auto right = this->value(infix->right.get());
+        if (m_inference.IntegerOnly(infix)) {
+            static const std::unordered_map<ast::Operator, std::string_view> integerOps{
+                {ast::Operator::Plus, "iadd"}, {ast::Operator::Minus, "isub"},
+                {ast::Operator::Asterisk, "imul"}, {ast::Operator::Slash, "idiv"},
+                {ast::Operator::LessThan, "ilt"}, {ast::Operator::GreaterThan, "igt"},
+                {ast::Operator::Equal, "ieq"}, {ast::Operator::NotEqual, "ine"},
+            };
+            if (const auto it = integerOps.find(infix->my_operator); it != integerOps.end()) {
+                return "monkey_rt::" + std::string{it->second} + "(" + left + ", " + right + ")";
+            }
+        }
+        return "monkey_rt::infix(\"" + std::string{ast::Spelling(infix->my_operator)} + "\", " + left + ", " + right + ")";
+    }
+
+    std::string ifExpression(const ast::IfExpression* ifExp) {
+        const auto condition = this->value(ifExp->condition.get());
+        const auto result = this->temp();
+        this->line("monkey_rt::Value " + result + " = monkey_rt::null();");
+        this->line("if (monkey_rt::truthy(" + condition + ")) {");
+        this->branch(ifExp->consequence.get(), result);
+        if (ifExp->alternative) {
+            this->line("} else {");
+            this->branch(ifExp->alternative.get(), result);
+        }
+        this->line("}");
+        return result;
+    }
+
+    void branch(const ast::BlockStatement* block, const std::string& result) {
+        ++m_indent;
+        if (block) {
+            this->line(result + " = " + this->statements(block->statements) + ";");
+        }
+        --m_indent;
+    }
+
+    // The cell of the let binding `literal` when the closure is only ever
+    // called through it and some escaping closure keeps the cell alive. The
+    // closure then holds its own cell weakly, so that the two do not keep
+    // each other alive once nothing else does.
+    std::string selfCell(const ast::FunctionLteral* literal) const {
+        const auto info = m_resolution.Function(literal);
+        if (!info || !info->parent) {
+            return {};
+        }
+        for (const auto binding : info->parent->locals) {
+            if (binding->function != literal || !m_functionName || binding->symbol != m_functionName->symbol ||
+                binding->declarations != 1 ||
+                binding->storage != resolver::Storage::Boxed || binding->reads != binding->calls) {
+                continue;
+            }
+            std::set<symbols::Symbol> reads;
+            collectInnerReads(literal->body.get(), true, reads);
+            const auto& cell = m_scopes.back().at(binding->symbol).name;
+            if (reads.contains(binding->symbol) && cell.starts_with("(*")) {
+                return cell.substr(2, cell.size() - 3);
+            }
+        }
+        return {};
+    }
+
+    std::string function(const ast::FunctionLteral* literal) {
+        const auto name = this->temp();
+        const auto self = this->selfCell(literal);
+        this->line("const monkey_rt::Value " + name + " = monkey_rt::function(" +
+            std::to_string(literal->parameters.size()) +
+            (self.empty() ? ", [=]" : ", [=, self = std::weak_ptr<monkey_rt::Value>{" + self + "}]") +
+            "(const std::vector<monkey_rt::Value>& args) -> monkey_rt::Value {");
+        ++m_indent;
+        this->line("static_cast<void>(args);");
+        if (!self.empty()) {
+            this->line("const auto " + self + " = self.lock();");
+        }
+        const auto functionName = m_functionName ? std::string{m_functionName->value} : "fn";
+        m_functionName = nullptr;
+        if (m_trace) {
+            this->line("const monkey_rt::Span span{\"" + functionName + "\"};");
+        }
+        if (m_profile) {
+            this->line("const monkey_rt::Frame frame{\"" + functionName + ':' + std::to_string(literal->line) + ':' +
+                       std::to_string(literal->column) + "\"};");
+        }
+
+        std::vector<symbols::Symbol> parameters;
+        for (const auto& parameter : literal->parameters) {
+            parameters.push_back(parameter->symbol);
+        }
+        std::set<symbols::Symbol> lets;
+        collectLets(literal->body.get(), lets);
+        std::set<symbols::Symbol> captured;
+        collectInnerReads(literal->body.get(), false, captured);
+        this->openScope(lets, parameters, captured);
+        // Cells no escaping closure can see die with the call; the rest may
+        // still be read after it returns.
+        std::vector<symbols::Symbol> frameCells;
+        if (const auto info = m_resolution.Function(literal)) {
+            for (const auto binding : info->locals) {
+                const auto name = binding->symbol;
+                if (binding->storage == resolver::Storage::Frame && captured.contains(name) &&
+                    std::find(frameCells.begin(), frameCells.end(), name) == frameCells.end()) {
+                    frameCells.push_back(name);
+                }
+            }
+        }
+        this->release(frameCells);
+
+        const auto value = literal->body ? this->statements(literal->body->statements) : "monkey_rt::null()";
+        this->line("return " + value + ";");
+        m_scopes.pop_back();
+
+        --m_indent;
+        this->line("});");
+        return name;
+    }
+
+    const resolver::Resolution& m_resolution;
+    const types::Inference& m_inference;
+    const purity::Analysis* m_purity;
+    bool m_trace;
+    bool m_profile;
+    std::vector<symbols::Symbol> m_inputs;
+    bool m_piece;
+    std::vector<symbols::Symbol> m_globals;
+    const ast::Identifier* m_functionName{}; // of the let binding the literal being emitted
+    std::ostringstream m_out;
+    int m_indent{};
+    uint32_t m_temps{};
+    std::vector<Scope> m_scopes;
+};
+
+} // namespace
+
+std::string emitter::EmitCpp(const ast::Program& program, const Options& options) {
+    const auto resolution = resolver::Resolve(program);
+    if (options.piece) {
+        return Emitter{resolution, types::Inference{}, nullptr, options}.Run(program);
+    }
+    const auto inference = types::Infer(program, resolution);
+    if (!options.memoize) {
+        return Emitter{resolution, inference, nullptr, options}.Run(program);
+    }
+    const auto purity = purity::Analyze(program, resolution);
+    return Emitter{resolution, inference, &purity, options}.Run(program);
+}
@@ -0,0 +1,99 @@
+#ifndef emitter_emitter_h
+#define emitter_emitter_h
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <ast/ast.h>
+
+namespace emitter
+{
+
+// The optimizer, the analyses and the emitter walk the tree recursively, and
+// the C++ compiler has its own nesting limits on the generated code; deeper
+// programs (see ast::Depth) are not translated.
+inline constexpr std::size_t MaxTranslatedDepth = 2000;
+
+// Translates a program into one self-contained C++20 translation unit.
+//
+// The unit carries its own small runtime (namespace monkey_rt) and defines
+//     monkey_rt::Value monkey_program(const monkey_value* inputs = nullptr);
+//     extern "C" const char* monkey_run();
+//     extern "C" int monkey_execute(const monkey_value* inputs, const monkey_limits* limits,
+//                                   monkey_value* result, monkey_usage* usage,
+//                                   char* error, std::size_t size);
+// monkey_run() evaluates the program once and returns its value as the REPL
+// would print it, or "ERROR: ..." for a runtime error, so the unit can be
+// built into a shared library and called through dlsym. Defining MONKEY_MAIN
+// adds a main() that prints that result. monkey_execute() evaluates it with
+// the globals named by `inputs` set from the array of the same name and
+// returns 0, or writes a runtime error to `error` and returns 1. Non-zero
+// `limits` end the run with "fuel exhausted" once it has made that many calls,
+// or with "timeout" once that many nanoseconds have passed, and "out of
+// memory" once its cells and closures take more bytes than that; `usage`
+// receives the bytes they took. Calls nested deeper than MONKEY_MAX_DEPTH
+// (4000 unless defined when the unit is compiled) end any run with "stack
+// overflow" before they exhaust the thread's stack. The runtime
+// keeps no state shared between threads beyond the trace and profile buffers:
+// every call has globals of its own and memo tables are per thread, so calls
+// may run concurrently.
+//
+// Bindings follow the book's environments: a function body is one scope, a
+// name read before its let runs falls through to the enclosing scope, and a
+// name captured by a nested function lives in a shared heap cell. Infix
+// operators that types::Infer proves integer-only skip the dynamic type check.
+//
+// With `memoize`, functions that purity::Analyze finds memoizable are wrapped
+// in a per-function cache keyed on integer and boolean arguments. A cache stops
+// growing at MONKEY_MEMO_LIMIT entries (a macro, 65536 unless defined when the
+// unit is compiled), and monkey_memo_stats() reports calls, hits and entries.
+//
+// With `trace`, every function call and the program as a whole are recorded as
+// spans named after the let binding the function, or "fn" for anonymous ones.
+// Run with MONKEY_TRACE=<file>, the program writes them there as Chrome
+// trace-event JSON at exit, keeping the last MONKEY_TRACE_EVENTS (65536) spans
+// per thread; without it a span costs one branch.
+//
+// With `profile`, calls are also kept on a shadow stack, as "name:line:column"
+// of the function literal as the parser located it. Run with
+// MONKEY_PROFILE=<file>, a thread samples it MONKEY_PROFILE_HZ times a second
+// (1000 unless set) and the program writes folded stacks for flame graph
+// tools there at exit.
+//
+// With `piece`, the program is one piece of a session such as the REPL's, and
+// the unit defines instead
+//     extern "C" int monkey_piece(monkey_globals* globals, monkey_value* result,
+//                                 char* error, std::size_t size);
+//     extern "C" void monkey_release(monkey_globals* globals);
+//     extern "C" void monkey_profile_start();
+//     extern "C" void monkey_profile_stop(void (*report)(const char* stack,
+//                                         std::uint64_t count, void* context),
+//                                         void* context);
+// where monkey_globals holds an opaque cell and a name for each of the
+// session's global slots, `globals` in Options. A piece makes the cells that
+// are still null and shares the others with earlier pieces; names no piece
+// had declared yet are looked up there when they are read, and
+// monkey_release frees every cell. Between monkey_profile_start and
+// monkey_profile_stop the shadow stacks of `profile` pieces are sampled, and
+// the samples are then reported a folded stack at a time. Pieces are not
+// type-specialized, since a later piece may call their functions with
+// anything.
+struct Options {
+    bool memoize{};
+    bool trace{};
+    bool profile{};
+    // Globals supplied by the host, in the order monkey_execute takes them.
+    // They are pasted into the code unchecked and must be identifiers.
+    std::vector<std::string> inputs{};
+    bool piece{};
+    // For a piece, the session's global slots in order: those declared by
+    // earlier pieces, then those this one adds.
+    std::vector<std::string> globals{};
+};
+
+std::string EmitCpp(const ast::Program& program, const Options& options = {});
+
+} // namespace emitter
+
+#endif // emitter_emitter_h
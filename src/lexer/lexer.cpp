@@ -1,10 +1,42 @@
 #include "lexer.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <memory>
 #include <string>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fmt/core.h>
+
+#include <symbols/symbols.h>
 #include <token/token.h>
 
 
+namespace
+{
+
+// read(2) that retries when interrupted and treats errors as the end of input.
+std::size_t readFd(int fd, char* buffer, std::size_t size) {
+    for (;;) {
+        const auto read = ::read(fd, buffer, size);
+        if (read >= 0) {
+            return static_cast<std::size_t>(read);
+        }
+        if (errno != EINTR) {
+            return 0;
+        }
+    }
+}
+
+} // namespace
+
 bool lexer::isLetter(uint8_t ch) {
     return 'a' <= ch && ch <= 'z' || 'A' <= ch && ch <= 'Z' || ch == '_';
 }
@@ -14,7 +46,15 @@ bool lexer::isDigit(uint8_t ch) {
 }
 
 lexer::Lexer::Lexer(std::string input) :
-        m_input{std::move(input)}
+        m_input{std::move(input)},
+        m_filled{m_input.size()}
+    {
+        this->readChar();
+    }
+
+lexer::Lexer::Lexer(Reader read, std::size_t chunkSize) :
+        m_read{std::move(read)},
+        m_chunkSize{chunkSize}
     {
         this->readChar();
     }
@@ -23,6 +63,9 @@ lexer::Lexer::Lexer(std::string input) :
         token::Token tok{};
 
         this->skipWhitespace();
+        m_tokenStart = m_position;
+        m_recent[m_tokens++ % RecentTokens] = m_tokenStart;
+        const auto offset = static_cast<uint32_t>(std::min<std::size_t>(m_tokenStart, UINT32_MAX));
 
         switch (m_ch)
         {
@@ -87,10 +130,15 @@ lexer::Lexer::Lexer(std::string input) :
             if (isLetter(m_ch)) {
                 tok.literal = this->readIdentifier();
                 tok.type = token::LookupIdent(tok.literal);
+                if (tok.type == token::IDENT) {
+                    tok.value = symbols::Intern(tok.literal);
+                }
+                tok.offset = offset;
                 return tok;
             } else if (isDigit(m_ch)) {
                 tok.type = token::INT;
-                tok.literal = this->readNumber();
+                this->readNumber(tok);
+                tok.offset = offset;
                 return tok;
             } else {
                 tok = token::Token(token::ILLEGAL, std::to_string(m_ch));
@@ -98,14 +146,40 @@ lexer::Lexer::Lexer(std::string input) :
         }
 
         this->readChar();
+        tok.offset = offset;
 	    return tok;
     }
 
+    // Drops what precedes the current token and appends the next chunk.
+    bool lexer::Lexer::fill() {
+        if (!m_read) {
+            return false;
+        }
+        this->scanLines(m_tokenStart);
+        this->forgetLines(m_tokens < RecentTokens ? m_recent[0] : m_recent[m_tokens % RecentTokens]);
+        const auto dropped = m_tokenStart - m_base;
+        std::memmove(m_input.data(), m_input.data() + dropped, m_filled - dropped);
+        m_filled -= dropped;
+        m_base = m_tokenStart;
+
+        // The buffer only grows, and so is only zero-filled, while a token
+        // spans more than a chunk; otherwise the reader writes over old bytes.
+        if (m_input.size() < m_filled + m_chunkSize) {
+            m_input.resize(m_filled + m_chunkSize);
+        }
+        const auto read = m_read(m_input.data() + m_filled, m_chunkSize);
+        m_filled += read;
+        if (read == 0) {
+            m_read = nullptr;
+        }
+        return read > 0;
+    }
+
     void lexer::Lexer::readChar() {
-        if (this->m_readPosition >= this->m_input.size()) {
+        if (this->m_readPosition - this->m_base >= this->m_filled && !this->fill()) {
             this->m_ch = 0;
         } else {
-            this->m_ch = this->m_input[this->m_readPosition];
+            this->m_ch = this->m_input[this->m_readPosition - this->m_base];
         }
         this->m_position = this->m_readPosition;
         ++this->m_readPosition;
@@ -113,15 +187,16 @@ lexer::Lexer::Lexer(std::string input) :
 
     void lexer::Lexer::skipWhitespace() {
         while (m_ch == ' ' || m_ch == '\t' || m_ch == '\n' || m_ch == '\r') {
+            m_tokenStart = m_readPosition;
             this->readChar();
         }
     }
 
     uint8_t lexer::Lexer::peekChar() {
-        if (m_readPosition >= m_input.size()) {
+        if (m_readPosition - m_base >= m_filled && !this->fill()) {
             return 0;
         }
-        return m_input[m_readPosition];
+        return m_input[m_readPosition - m_base];
     }
 
     std::string lexer::Lexer::readIdentifier() {
@@ -129,14 +204,122 @@ lexer::Lexer::Lexer(std::string input) :
         while (isLetter(m_ch)) {
             this->readChar();
         }
-        return m_input.substr(position, m_position - position);
+        return m_input.substr(position - m_base, m_position - position);
     }
 
-    std::string lexer::Lexer::readNumber() {
+    void lexer::Lexer::readNumber(token::Token& tok) {
         const auto position = m_position;
+        int64_t value{};
+        bool overflow{};
         while (isDigit(m_ch)) {
+            overflow = overflow || __builtin_mul_overflow(value, 10, &value) || __builtin_add_overflow(value, m_ch - '0', &value);
             this->readChar();
         }
-        return m_input.substr(position, m_position - position);
+        tok.literal = m_input.substr(position - m_base, m_position - position);
+        if (overflow) {
+            const auto [line, column] = this->Locate(static_cast<uint32_t>(std::min<std::size_t>(position, UINT32_MAX)));
+            m_errors.emplace_back(fmt::format("{}:{}: integer literal {} does not fit in 64 bits", line, column, tok.literal));
+        } else {
+            tok.value = value;
+        }
+    }
+
+    const std::vector<std::string>& lexer::Lexer::Errors() const {
+        return m_errors;
+    }
+
+    void lexer::Lexer::scanLines(std::size_t end) {
+        end = std::min(end, m_base + m_filled);
+        if (end <= m_scanned) {
+            return;
+        }
+        // memchr compares a vector register's worth of bytes at a time.
+        const auto data = m_input.data();
+        const auto last = end - m_base;
+        for (auto at = m_scanned - m_base; at < last;) {
+            const auto newline = static_cast<const char*>(std::memchr(data + at, '\n', last - at));
+            if (!newline) {
+                break;
+            }
+            at = newline - data + 1;
+            m_lineStarts.push_back(static_cast<uint32_t>(std::min<std::size_t>(m_base + at, UINT32_MAX)));
+        }
+        m_scanned = end;
+    }
+
+    void lexer::Lexer::forgetLines(std::size_t before) {
+        const auto next = std::upper_bound(m_lineStarts.begin(), m_lineStarts.end(), before);
+        const auto forgotten = next - m_lineStarts.begin() - 1;
+        if (forgotten > 0) {
+            m_lineStarts.erase(m_lineStarts.begin(), m_lineStarts.begin() + forgotten);
+            m_firstLine += static_cast<uint32_t>(forgotten);
+        }
+    }
+
+    lexer::Location lexer::Lexer::Locate(uint32_t offset) {
+        this->scanLines(static_cast<std::size_t>(offset) + 1);
+        if (offset < m_lineStarts.front()) {
+            return {0, 0};
+        }
+        const auto next = std::upper_bound(m_lineStarts.begin(), m_lineStarts.end(), offset);
+        const auto line = m_firstLine + static_cast<uint32_t>(next - m_lineStarts.begin() - 1);
+        return {line, offset - *(next - 1) + 1};
+    }
+
+lexer::Lexer lexer::FromStream(std::istream& in, std::size_t chunkSize) {
+    return Lexer([&in](char* buffer, std::size_t size) -> std::size_t {
+        in.read(buffer, static_cast<std::streamsize>(size));
+        return static_cast<std::size_t>(in.gcount());
+    }, chunkSize);
+}
+
+lexer::Lexer lexer::FromFd(int fd, std::size_t chunkSize) {
+    return Lexer([fd](char* buffer, std::size_t size) {
+        return readFd(fd, buffer, size);
+    }, chunkSize);
+}
+
+std::optional<lexer::Lexer> lexer::FromFile(const std::string& path, std::size_t chunkSize) {
+    struct File {
+        ~File() {
+            ::close(fd);
+        }
+        int fd;
+    };
+    struct Mapping {
+        ~Mapping() {
+            ::munmap(const_cast<char*>(data), size);
+        }
+        const char* data;
+        std::size_t size;
+    };
+
+    const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return std::nullopt;
+    }
+    auto file = std::make_shared<File>(fd);
+    struct stat info{};
+    void* data = MAP_FAILED;
+    if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        data = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
     }
+    if (data == MAP_FAILED) {
+        return Lexer([file](char* buffer, std::size_t size) {
+            return readFd(file->fd, buffer, size);
+        }, chunkSize);
+    }
+
+    // The mapping outlives the descriptor.
+    file.reset();
+    const auto size = static_cast<std::size_t>(info.st_size);
+    ::madvise(data, size, MADV_SEQUENTIAL);
+    auto mapping = std::make_shared<Mapping>(static_cast<const char*>(data), size);
+    return Lexer([mapping, offset = std::size_t{}](char* buffer, std::size_t size) mutable {
+        const auto n = std::min(size, mapping->size - offset);
+        std::memcpy(buffer, mapping->data + offset, n);
+        offset += n;
+        return n;
+    }, chunkSize);
+}
 
@@ -1,7 +1,13 @@
 #ifndef lexer_lexer_h
 #define lexer_lexer_h
 
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <optional>
 #include <string>
+#include <vector>
 
 #include <token/token.h>
 
@@ -12,14 +18,54 @@ bool isLetter(uint8_t ch);
 
 bool isDigit(uint8_t ch);
 
+// 1-based position of a byte in the input; columns count bytes.
+struct Location {
+    uint32_t line;
+    uint32_t column;
+};
+
+// Fills `buffer` with up to `size` bytes of input and returns how many it
+// wrote; 0 means the input is exhausted.
+using Reader = std::function<std::size_t(char* buffer, std::size_t size)>;
+
 class Lexer
 {
 public:
+    static constexpr std::size_t DefaultChunkSize = 64 * 1024;
+
     explicit Lexer(std::string input);
 
+    // Pulls input through `read` in chunks of `chunkSize` bytes as tokens are
+    // requested. Only the token being scanned and the unread rest of the last
+    // chunk are kept, so a token may straddle any number of chunks.
+    explicit Lexer(Reader read, std::size_t chunkSize = DefaultChunkSize);
+
     token::Token NextToken();
 
+    // Problems found in the tokens returned so far, such as integer literals
+    // that do not fit in 64 bits.
+    const std::vector<std::string>& Errors() const;
+
+    // Line and column of a token offset. Line starts are only looked for when
+    // a location is first asked for, except in text a streaming lexer is about
+    // to drop, where they are counted on the way out. A streaming lexer only
+    // remembers the line starts from its last RecentTokens tokens on, so older
+    // offsets locate to {0, 0}.
+    Location Locate(uint32_t offset);
+
+    // How many of the last tokens returned stay locatable: enough for a
+    // parser's lookahead and the token it is on.
+    static constexpr std::size_t RecentTokens = 8;
+
 private:
+    bool fill();
+
+    // Records the line starts in the input up to offset `end`.
+    void scanLines(std::size_t end);
+
+    // Forgets the line starts before the line that holds offset `before`.
+    void forgetLines(std::size_t before);
+
     void readChar();
 
     void skipWhitespace();
@@ -28,14 +74,39 @@ private:
 
     std::string readIdentifier();
 
-    std::string readNumber();
+    // Reads the digits and decodes them into `tok` in the same pass.
+    void readNumber(token::Token& tok);
 
-    std::string m_input;
-    int32_t m_position{};
-    int32_t m_readPosition{};
+    Reader m_read;
+    std::size_t m_chunkSize{};
+    std::string m_input; // the input from offset m_base on, in its first m_filled bytes
+    std::size_t m_filled{};
+    std::size_t m_base{};
+    std::size_t m_tokenStart{};
+    std::vector<std::string> m_errors;
+    std::vector<uint32_t> m_lineStarts{0}; // in order, the first being that of line m_firstLine
+    uint32_t m_firstLine{1};
+    std::size_t m_scanned{}; // line starts before this offset are recorded
+    std::array<std::size_t, RecentTokens> m_recent{}; // starts of the last tokens, by count modulo RecentTokens
+    std::size_t m_tokens{};
+    std::size_t m_position{};
+    std::size_t m_readPosition{};
     uint8_t m_ch;
 };
 
+// Lexers over input that arrives while tokens are being read: a stream, or a
+// file descriptor such as a pipe. Neither takes ownership. FromStream reads
+// whole chunks, waiting for each to fill, while FromFd takes whatever a read
+// returns, which suits interactive input.
+Lexer FromStream(std::istream& in, std::size_t chunkSize = Lexer::DefaultChunkSize);
+Lexer FromFd(int fd, std::size_t chunkSize = Lexer::DefaultChunkSize);
+
+// A lexer over the file at `path`, which it keeps open. A regular file is
+// mapped into memory and copied out a chunk at a time rather than read with a
+// system call per chunk; anything else is read like FromFd. nullopt if the
+// file cannot be opened.
+std::optional<Lexer> FromFile(const std::string& path, std::size_t chunkSize = Lexer::DefaultChunkSize);
+
 }
 
 #endif // lexer_lexer_h
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef lexer_token_stream_h
+#define lexer_token_stream_h
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <lexer/lexer.h>
+#include <token/token.h>
+
+namespace lexer
+{
+
+// Tokens of a Lexer, read only when first looked at and kept in a fixed ring
+// of `Lookahead` slots until taken. Taking a token moves it out of the ring,
+// so a token's strings are never copied on their way to the parser.
+template <std::size_t Lookahead>
+class TokenStream
+{
+    static_assert(Lookahead > 0 && (Lookahead & (Lookahead - 1)) == 0, "Lookahead must be a power of two");
+
+public:
+    explicit TokenStream(Lexer lexer) :
+        m_lexer{std::move(lexer)}
+    {}
+
+    // The token `n` places after the last one taken; 0 is the next one.
+    const token::Token& Peek(std::size_t n = 0) {
+        while (m_size <= n) {
+            m_ring[(m_head + m_size) & (Lookahead - 1)] = m_lexer.NextToken();
+            ++m_size;
+        }
+        return m_ring[(m_head + n) & (Lookahead - 1)];
+    }
+
+    token::Token Next() {
+        this->Peek();
+        auto tok = std::move(m_ring[m_head]);
+        m_head = (m_head + 1) & (Lookahead - 1);
+        --m_size;
+        return tok;
+    }
+
+    const std::vector<std::string>& Errors() const {
+        return m_lexer.Errors();
+    }
+
+    Location Locate(uint32_t offset) {
+        return m_lexer.Locate(offset);
+    }
+
+private:
+    Lexer m_lexer;
+    std::array<token::Token, Lookahead> m_ring;
+    std::size_t m_head{};
+    std::size_t m_size{};
+};
+
+} // namespace lexer
+
+#endif // lexer_token_stream_h
@@ -1,7 +1,315 @@
+#include <cerrno>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
 
+#include <unistd.h>
+
+#include <emitter/emitter.h>
+#include <lexer/lexer.h>
+#include <optimizer/optimizer.h>
+#include <parser/parser.h>
 #include <repl/repl.h>
+#include <script/script.h>
+#include <stats/stats.h>
+#include <trace/trace.h>
+
+namespace
+{
+
+// Collects output and hands it to write(2) a megabyte at a time; iostreams
+// would make a call per line for a terminal and go through std::cout's
+// synchronisation with stdio.
+class Output
+{
+public:
+    static constexpr std::size_t Capacity = 1 << 20;
+
+    Output() {
+        this->m_buffer.reserve(Capacity);
+    }
+
+    ~Output() {
+        this->flush();
+    }
+
+    Output(const Output&) = delete;
+    Output& operator=(const Output&) = delete;
+
+    void Append(std::string_view text) {
+        this->m_buffer += text;
+        if (this->m_buffer.size() >= Capacity) {
+            this->flush();
+        }
+    }
+
+private:
+    void flush() {
+        std::string_view rest = this->m_buffer;
+        while (!rest.empty()) {
+            const auto written = ::write(STDOUT_FILENO, rest.data(), rest.size());
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written < 0) {
+                break;
+            }
+            rest.remove_prefix(static_cast<std::size_t>(written));
+        }
+        this->m_buffer.clear();
+    }
+
+    std::string m_buffer;
+};
+
+// "-" is standard input; files are memory-mapped when possible.
+std::optional<lexer::Lexer> openInput(std::string_view path) {
+    if (path == "-") {
+        return lexer::FromFd(STDIN_FILENO);
+    }
+    auto lexer = lexer::FromFile(std::string{path});
+    if (!lexer) {
+        std::cerr << "cannot open " << path << '\n';
+    }
+    return lexer;
+}
+
+// monkey.exe --tokens <file|->
+// monkey.exe --ast <file|->
+//
+// Prints the token stream, as "TYPE literal" lines, or each parsed statement
+// on a line of its own, as the input is read.
+int dump(const std::vector<std::string_view>& args) {
+    if (args.size() != 2) {
+        std::cerr << "usage: monkey.exe " << args[0] << " <file|->\n";
+        return 2;
+    }
+    auto lexer = openInput(args[1]);
+    if (!lexer) {
+        return 1;
+    }
+
+    std::vector<std::string> errors;
+    {
+        Output out;
+        if (args[0] == "--tokens") {
+            for (auto tok = lexer->NextToken(); tok.type != token::eof; tok = lexer->NextToken()) {
+                out.Append(tok.type);
+                out.Append(" ");
+                out.Append(tok.literal);
+                out.Append("\n");
+            }
+            errors = lexer->Errors();
+        } else {
+            auto p = Parser(std::move(*lexer));
+            while (const auto statement = p.ParseNextStatement()) {
+                out.Append(statement->String());
+                out.Append("\n");
+            }
+            errors = p.Errors();
+        }
+    }
+    for (const auto& error : errors) {
+        std::cerr << args[1] << ':' << error << '\n';
+    }
+    return errors.empty() ? 0 : 1;
+}
+
+// monkey.exe run <file|->
+//
+// Builds the program with script::CompiledScript, runs it once and prints its
+// value, or the error it failed with.
+int run(const std::vector<std::string_view>& args) {
+    if (args.size() != 2) {
+        std::cerr << "usage: monkey.exe run <file|->\n";
+        return 2;
+    }
+    std::ifstream file;
+    if (args[1] != "-") {
+        file.open(std::string{args[1]}, std::ios::binary);
+        if (!file) {
+            std::cerr << "cannot open " << args[1] << '\n';
+            return 1;
+        }
+    }
+
+    std::vector<std::string> errors;
+    const auto compiled = script::CompiledScript::Compile(args[1] == "-" ? std::cin : file, {}, errors);
+    if (!compiled) {
+        for (const auto& error : errors) {
+            std::cerr << args[1] << ':' << error << '\n';
+        }
+        return 1;
+    }
+    const auto result = compiled->Execute();
+    Output out;
+    if (!result.error.empty()) {
+        out.Append("ERROR: " + result.error + '\n');
+        return 1;
+    }
+    out.Append(script::Inspect(result.value) + '\n');
+    return 0;
+}
+
+// Handles --trace=<out.json> in args[1], starting a trace of the compiler's
+// phases that is written out at exit.
+bool traceOption(std::vector<std::string_view>& args) {
+    constexpr std::string_view option = "--trace=";
+    if (args.size() < 2 || !args[1].starts_with(option)) {
+        return false;
+    }
+    trace::Start(std::string{args[1].substr(option.size())});
+    args.erase(args.begin() + 1);
+    return true;
+}
+
+// monkey.exe emit-cpp [--memoize] [--trace=<out.json>] [--profile] <file|-> [-o <out.cpp>]
+//
+// With --trace the generated code also records its function calls, and with
+// --profile it can be sampled; see emitter::Options.
+int emitCpp(std::vector<std::string_view> args) {
+    emitter::Options options;
+    while (true) {
+        if (args.size() > 1 && args[1] == "--memoize") {
+            options.memoize = true;
+            args.erase(args.begin() + 1);
+        } else if (traceOption(args)) {
+            options.trace = true;
+        } else if (args.size() > 1 && args[1] == "--profile") {
+            options.profile = true;
+            args.erase(args.begin() + 1);
+        } else {
+            break;
+        }
+    }
+    if (args.size() != 2 && !(args.size() == 4 && args[2] == "-o")) {
+        std::cerr << "usage: monkey.exe emit-cpp [--memoize] [--trace=<out.json>] [--profile] <file|-> [-o <out.cpp>]\n";
+        return 2;
+    }
+
+    // "-" reads the program from standard input.
+    std::ifstream in;
+    if (args[1] != "-") {
+        in.open(std::string{args[1]}, std::ios::binary);
+        if (!in) {
+            std::cerr << "cannot open " << args[1] << '\n';
+            return 1;
+        }
+    }
+    // The lexer runs inside the parser, so "parse" covers reading and lexing.
+    auto p = Parser(args[1] == "-" ? lexer::FromFd(STDIN_FILENO) : lexer::FromStream(in));
+    ast::Program program;
+    {
+        const stats::Scope scope{"parse"};
+        program = p.ParseProgram();
+    }
+    if (!p.Errors().empty()) {
+        for (const auto& error : p.Errors()) {
+            std::cerr << args[1] << ':' << error << '\n';
+        }
+        return 1;
+    }
+    if (ast::Depth(program) > emitter::MaxTranslatedDepth) {
+        std::cerr << args[1] << ": expressions nested deeper than " << emitter::MaxTranslatedDepth << " cannot be translated\n";
+        return 1;
+    }
+    optimizer::Optimize(program);
+
+    std::string code;
+    {
+        const stats::Scope scope{"emit"};
+        code = emitter::EmitCpp(program, options);
+    }
+    if (args.size() == 2) {
+        std::cout << code;
+        return 0;
+    }
+    std::ofstream out{std::string{args[3]}, std::ios::binary};
+    out << code;
+    return out ? 0 : 1;
+}
+
+// monkey.exe --stats[=json] [--trace=<out.json>] <file|->
+//
+// Runs the emit-cpp pipeline without writing anything and prints what each
+// phase cost. The lexer normally runs inside the parser, so here it also runs
+// once on its own: "parse" includes a second lexing pass.
+int printStats(std::vector<std::string_view> args) {
+    traceOption(args);
+    if (args.size() != 2 || (args[0] != "--stats" && args[0] != "--stats=json")) {
+        std::cerr << "usage: monkey.exe --stats[=json] [--trace=<out.json>] <file|->\n";
+        return 2;
+    }
+
+    stats::Report report;
+    stats::Start(report);
+    std::string source;
+    {
+        const stats::Scope scope{"read"};
+        std::ifstream file;
+        if (args[1] != "-") {
+            file.open(std::string{args[1]}, std::ios::binary);
+            if (!file) {
+                stats::Stop();
+                std::cerr << "cannot open " << args[1] << '\n';
+                return 1;
+            }
+        }
+        std::istream& in = args[1] == "-" ? std::cin : file;
+        source.assign(std::istreambuf_iterator<char>{in}, {});
+    }
+    {
+        const stats::Scope scope{"lex"};
+        auto lexer = lexer::Lexer(source);
+        for (auto tok = lexer.NextToken(); tok.type != token::eof; tok = lexer.NextToken()) {
+            ++report.tokens;
+        }
+    }
+
+    auto p = Parser(lexer::Lexer(source));
+    ast::Program program;
+    {
+        const stats::Scope scope{"parse"};
+        program = p.ParseProgram();
+    }
+    if (!p.Errors().empty()) {
+        stats::Stop();
+        for (const auto& error : p.Errors()) {
+            std::cerr << args[1] << ':' << error << '\n';
+        }
+        return 1;
+    }
+    report.nodes = ast::Census(program);
+    if (ast::Depth(program) <= emitter::MaxTranslatedDepth) {
+        optimizer::Optimize(program);
+        const stats::Scope scope{"emit"};
+        emitter::EmitCpp(program);
+    }
+    stats::Stop();
+
+    std::cout << (args[0] == "--stats" ? stats::Table(report) : stats::Json(report));
+    return 0;
+}
+
+} // namespace
 
-int main() {
+int main(int argc, char* argv[]) {
+    const std::vector<std::string_view> args(argv + 1, argv + argc);
+    if (!args.empty() && args[0] == "run") {
+        return run(args);
+    }
+    if (!args.empty() && args[0] == "emit-cpp") {
+        return emitCpp(args);
+    }
+    if (!args.empty() && args[0].starts_with("--stats")) {
+        return printStats(args);
+    }
+    if (!args.empty() && (args[0] == "--tokens" || args[0] == "--ast")) {
+        return dump(args);
+    }
     repl::Start();
-}
\ No newline at end of file
+}
@@ -0,0 +1,632 @@
+#include "optimizer.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include <stats/stats.h>
+#include <types/types.h>
+
+namespace
+{
+
+// Walks every expression of a program and offers each one, after its
+// children, to rewrite(), which may replace it through the slot. Statement
+// lists are likewise offered to rewriteStatements() once walked.
+class Rewriter
+{
+public:
+    virtual ~Rewriter() = default;
+
+    void Run(ast::Program& program) {
+        this->statements(program.statements);
+    }
+
+protected:
+    virtual void rewrite(std::shared_ptr<ast::Expression>&) {}
+
+    virtual void rewriteStatements(std::vector<std::shared_ptr<ast::Statement>>&) {}
+
+    virtual void enterFunction(ast::FunctionLteral*) {}
+
+    virtual void leaveFunction(ast::FunctionLteral*) {}
+
+    void statements(std::vector<std::shared_ptr<ast::Statement>>& statements) {
+        for (auto& statement : statements) {
+            this->statement(statement.get());
+        }
+        this->rewriteStatements(statements);
+    }
+
+    void statement(ast::Statement* statement) {
+        if (const auto let = dynamic_cast<ast::LetStatement*>(statement)) {
+            this->expression(let->value);
+        } else if (const auto ret = dynamic_cast<ast::ReturnStatement*>(statement)) {
+            this->expression(ret->returnValue);
+        } else if (const auto exp = dynamic_cast<ast::ExpressionStatement*>(statement)) {
+            this->expression(exp->expression);
+        } else if (const auto block = dynamic_cast<ast::BlockStatement*>(statement)) {
+            this->statements(block->statements);
+        }
+    }
+
+    void expression(std::shared_ptr<ast::Expression>& slot) {
+        const auto expression = slot.get();
+        if (const auto prefix = dynamic_cast<ast::PrefixExpression*>(expression)) {
+            this->expression(prefix->right);
+        } else if (const auto infix = dynamic_cast<ast::InfixExpression*>(expression)) {
+            this->expression(infix->left);
+            this->expression(infix->right);
+        } else if (const auto ifExp = dynamic_cast<ast::IfExpression*>(expression)) {
+            this->expression(ifExp->condition);
+            if (ifExp->consequence) {
+                this->statements(ifExp->consequence->statements);
+            }
+            if (ifExp->alternative) {
+                this->statements(ifExp->alternative->statements);
+            }
+        } else if (const auto literal = dynamic_cast<ast::FunctionLteral*>(expression)) {
+            this->enterFunction(literal);
+            if (literal->body) {
+                this->statements(literal->body->statements);
+            }
+            this->leaveFunction(literal);
+        } else if (const auto call = dynamic_cast<ast::CallExpression*>(expression)) {
+            this->expression(call->function);
+            for (auto& argument : call->arguments) {
+                this->expression(argument);
+            }
+        }
+
+        if (slot) {
+            this->rewrite(slot);
+        }
+    }
+};
+
+// Whether evaluating the expression can neither fail nor call anything, so
+// that dropping, repeating or reordering it is unobservable.
+bool safe(const ast::Expression* expression, const resolver::Resolution& resolution) {
+    if (const auto identifier = dynamic_cast<const ast::Identifier*>(expression)) {
+        return resolution.Use(identifier);
+    }
+    if (dynamic_cast<const ast::IntegerLiteral*>(expression) || dynamic_cast<const ast::Boolean*>(expression) ||
+        dynamic_cast<const ast::FunctionLteral*>(expression)) {
+        return true;
+    }
+    if (const auto prefix = dynamic_cast<const ast::PrefixExpression*>(expression)) {
+        return prefix->my_operator == ast::Operator::Bang && safe(prefix->right.get(), resolution);
+    }
+    if (const auto infix = dynamic_cast<const ast::InfixExpression*>(expression)) {
+        const auto left = dynamic_cast<const ast::IntegerLiteral*>(infix->left.get());
+        const auto right = dynamic_cast<const ast::IntegerLiteral*>(infix->right.get());
+        if (left && right && infix->my_operator != ast::Operator::Equal &&
+            infix->my_operator != ast::Operator::NotEqual) {
+            int64_t result{};
+            return infix->my_operator == ast::Operator::LessThan || infix->my_operator == ast::Operator::GreaterThan ||
+                types::Arithmetic(infix->my_operator, left->value, right->value, result) == types::Fault::None;
+        }
+        return (infix->my_operator == ast::Operator::Equal || infix->my_operator == ast::Operator::NotEqual) &&
+            safe(infix->left.get(), resolution) && safe(infix->right.get(), resolution);
+    }
+    return false;
+}
+
+bool isTrivial(const ast::Expression* expression) {
+    return dynamic_cast<const ast::Identifier*>(expression) ||
+        dynamic_cast<const ast::IntegerLiteral*>(expression) ||
+        dynamic_cast<const ast::Boolean*>(expression);
+}
+
+const ast::Expression* singleExpression(const ast::BlockStatement* block) {
+    if (!block || block->statements.size() != 1) {
+        return nullptr;
+    }
+    const auto statement = block->statements[0].get();
+    if (const auto exp = dynamic_cast<const ast::ExpressionStatement*>(statement)) {
+        return exp->expression.get();
+    }
+    return nullptr;
+}
+
+// Visits the identifiers of an expression that may be copied into a caller,
+// or returns false if the expression has anything else: a nested function, a
+// block with more than one expression, a let or a return.
+template <typename Fn>
+bool forEachIdentifier(const ast::Expression* expression, uint32_t& size, bool& hasCall, Fn&& fn) {
+    ++size;
+    if (const auto identifier = dynamic_cast<const ast::Identifier*>(expression)) {
+        fn(identifier);
+        return true;
+    }
+    if (dynamic_cast<const ast::IntegerLiteral*>(expression) || dynamic_cast<const ast::Boolean*>(expression)) {
+        return true;
+    }
+    if (const auto prefix = dynamic_cast<const ast::PrefixExpression*>(expression)) {
+        return forEachIdentifier(prefix->right.get(), size, hasCall, fn);
+    }
+    if (const auto infix = dynamic_cast<const ast::InfixExpression*>(expression)) {
+        return forEachIdentifier(infix->left.get(), size, hasCall, fn) &&
+            forEachIdentifier(infix->right.get(), size, hasCall, fn);
+    }
+    if (const auto call = dynamic_cast<const ast::CallExpression*>(expression)) {
+        hasCall = true;
+        if (!forEachIdentifier(call->function.get(), size, hasCall, fn)) {
+            return false;
+        }
+        for (const auto& argument : call->arguments) {
+            if (!forEachIdentifier(argument.get(), size, hasCall, fn)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if (const auto ifExp = dynamic_cast<const ast::IfExpression*>(expression)) {
+        const auto consequence = singleExpression(ifExp->consequence.get());
+        const auto alternative = singleExpression(ifExp->alternative.get());
+        if (!consequence || (ifExp->alternative && !alternative)) {
+            return false;
+        }
+        return forEachIdentifier(ifExp->condition.get(), size, hasCall, fn) &&
+            forEachIdentifier(consequence, size, hasCall, fn) &&
+            (!alternative || forEachIdentifier(alternative, size, hasCall, fn));
+    }
+    return false;
+}
+
+using Substitutions = std::unordered_map<symbols::Symbol, const ast::Expression*>;
+
+std::shared_ptr<ast::Expression> clone(const ast::Expression* expression, const Substitutions& substitutions,
+                                       const std::shared_ptr<ast::Arena>& arena);
+
+std::shared_ptr<ast::BlockStatement> cloneBlock(const ast::BlockStatement* block, const Substitutions& substitutions,
+                                                const std::shared_ptr<ast::Arena>& arena) {
+    if (!block) {
+        return {};
+    }
+    auto copy = ast::MakeNode<ast::BlockStatement>(arena);
+    for (const auto& statement : block->statements) {
+        const auto exp = dynamic_cast<const ast::ExpressionStatement*>(statement.get());
+        auto stmt = ast::MakeNode<ast::ExpressionStatement>(arena);
+        stmt->expression = clone(exp->expression.get(), substitutions, arena);
+        copy->statements.push_back(std::move(stmt));
+    }
+    return copy;
+}
+
+// Deep copy of an expression accepted by forEachIdentifier, allocated in `arena`.
+std::shared_ptr<ast::Expression> clone(const ast::Expression* expression, const Substitutions& substitutions,
+                                       const std::shared_ptr<ast::Arena>& arena) {
+    if (const auto identifier = dynamic_cast<const ast::Identifier*>(expression)) {
+        if (const auto it = substitutions.find(identifier->symbol); it != substitutions.end()) {
+            return clone(it->second, {}, arena);
+        }
+        return ast::MakeNode<ast::Identifier>(arena, *identifier);
+    }
+    if (const auto integer = dynamic_cast<const ast::IntegerLiteral*>(expression)) {
+        return ast::MakeNode<ast::IntegerLiteral>(arena, *integer);
+    }
+    if (const auto boolean = dynamic_cast<const ast::Boolean*>(expression)) {
+        return ast::MakeNode<ast::Boolean>(arena, *boolean);
+    }
+    if (const auto prefix = dynamic_cast<const ast::PrefixExpression*>(expression)) {
+        auto copy = ast::MakeNode<ast::PrefixExpression>(arena);
+        copy->my_operator = prefix->my_operator;
+        copy->right = clone(prefix->right.get(), substitutions, arena);
+        return copy;
+    }
+    if (const auto infix = dynamic_cast<const ast::InfixExpression*>(expression)) {
+        auto copy = ast::MakeNode<ast::InfixExpression>(arena);
+        copy->left = clone(infix->left.get(), substitutions, arena);
+        copy->my_operator = infix->my_operator;
+        copy->right = clone(infix->right.get(), substitutions, arena);
+        return copy;
+    }
+    if (const auto call = dynamic_cast<const ast::CallExpression*>(expression)) {
+        auto copy = ast::MakeNode<ast::CallExpression>(arena);
+        copy->function = clone(call->function.get(), substitutions, arena);
+        for (const auto& argument : call->arguments) {
+            copy->arguments.push_back(clone(argument.get(), substitutions, arena));
+        }
+        return copy;
+    }
+    const auto ifExp = dynamic_cast<const ast::IfExpression*>(expression);
+    auto copy = ast::MakeNode<ast::IfExpression>(arena);
+    copy->condition = clone(ifExp->condition.get(), substitutions, arena);
+    copy->consequence = cloneBlock(ifExp->consequence.get(), substitutions, arena);
+    copy->alternative = cloneBlock(ifExp->alternative.get(), substitutions, arena);
+    return copy;
+}
+
+class Inliner : public Rewriter
+{
+public:
+    Inliner(const resolver::Resolution& resolution, uint32_t budget, std::shared_ptr<ast::Arena> arena) :
+        m_resolution{resolution},
+        m_budget{budget},
+        m_arena{std::move(arena)}
+    {}
+
+    uint32_t inlined() const {
+        return m_inlined;
+    }
+
+private:
+    void enterFunction(ast::FunctionLteral* literal) override {
+        m_enclosing.push_back(m_resolution.Function(literal));
+    }
+
+    void leaveFunction(ast::FunctionLteral*) override {
+        m_enclosing.pop_back();
+    }
+
+    bool shadowed(symbols::Symbol name) const {
+        for (const auto function : m_enclosing) {
+            if (!function) {
+                return true;
+            }
+            for (const auto local : function->locals) {
+                if (local->symbol == name) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void rewrite(std::shared_ptr<ast::Expression>& slot) override {
+        const auto call = dynamic_cast<ast::CallExpression*>(slot.get());
+        if (!call) {
+            return;
+        }
+        const auto callee = dynamic_cast<ast::Identifier*>(call->function.get());
+        const auto binding = callee ? m_resolution.Use(callee) : nullptr;
+        if (!binding || binding->owner || binding->declarations != 1 || !binding->function) {
+            return;
+        }
+
+        const auto function = binding->function;
+        if (function->parameters.size() != call->arguments.size() || !function->body ||
+            function->body->statements.size() != 1) {
+            return;
+        }
+
+        const ast::Expression* body{};
+        const auto statement = function->body->statements[0].get();
+        if (const auto exp = dynamic_cast<const ast::ExpressionStatement*>(statement)) {
+            body = exp->expression.get();
+        } else if (const auto ret = dynamic_cast<const ast::ReturnStatement*>(statement)) {
+            body = ret->returnValue.get();
+        }
+        if (!body) {
+            return;
+        }
+
+        Substitutions substitutions;
+        std::unordered_map<symbols::Symbol, uint32_t> uses;
+        for (std::size_t i = 0; i < call->arguments.size(); ++i) {
+            substitutions.emplace(function->parameters[i]->symbol, call->arguments[i].get());
+            uses.emplace(function->parameters[i]->symbol, 0);
+        }
+
+        uint32_t size{};
+        bool hasCall{};
+        bool hygienic = true;
+        const auto copyable = forEachIdentifier(body, size, hasCall, [&](const ast::Identifier* identifier) {
+            if (const auto it = uses.find(identifier->symbol); it != uses.end()) {
+                ++it->second;
+            } else if (identifier->symbol == binding->symbol || this->shadowed(identifier->symbol)) {
+                hygienic = false;
+            }
+        });
+        if (!copyable || !hygienic || size > m_budget) {
+            return;
+        }
+
+        // The body may evaluate an argument never, twice or out of order, so
+        // only arguments that cannot fail are substituted. Binding the others
+        // to a let first would need a let in expression position, which Monkey
+        // lacks, so such calls stay.
+        for (const auto& [name, argument] : substitutions) {
+            uint32_t argumentSize{};
+            bool argumentHasCall{};
+            const auto copyable =
+                forEachIdentifier(argument, argumentSize, argumentHasCall, [](const ast::Identifier*) {});
+            if (!copyable || !safe(argument, m_resolution) || (!isTrivial(argument) && uses[name] != 1)) {
+                return;
+            }
+        }
+
+        // The replaced call stays alive until the pass is over: the resolution
+        // is keyed by node address and must not see a freed one reused.
+        m_replaced.push_back(slot);
+        slot = clone(body, substitutions, m_arena);
+        ++m_inlined;
+    }
+
+    const resolver::Resolution& m_resolution;
+    uint32_t m_budget;
+    uint32_t m_inlined{};
+    std::vector<const resolver::FunctionInfo*> m_enclosing;
+    std::vector<std::shared_ptr<ast::Expression>> m_replaced;
+    std::shared_ptr<ast::Arena> m_arena;
+};
+
+std::shared_ptr<ast::Expression> makeInteger(int64_t value, const std::shared_ptr<ast::Arena>& arena) {
+    auto literal = ast::MakeNode<ast::IntegerLiteral>(arena);
+    literal->value = value;
+    return literal;
+}
+
+std::shared_ptr<ast::Expression> makeBoolean(bool value, const std::shared_ptr<ast::Arena>& arena) {
+    auto literal = ast::MakeNode<ast::Boolean>(arena);
+    literal->value = value;
+    return literal;
+}
+
+std::shared_ptr<ast::Expression> foldInfix(ast::Operator op, int64_t left, int64_t right,
+                                           const std::shared_ptr<ast::Arena>& arena) {
+    switch (op) {
+    case ast::Operator::Plus:
+    case ast::Operator::Minus:
+    case ast::Operator::Asterisk:
+    case ast::Operator::Slash: {
+        int64_t result{};
+        return types::Arithmetic(op, left, right, result) == types::Fault::None ? makeInteger(result, arena) : nullptr;
+    }
+    case ast::Operator::LessThan:
+        return makeBoolean(left < right, arena);
+    case ast::Operator::GreaterThan:
+        return makeBoolean(left > right, arena);
+    case ast::Operator::Equal:
+        return makeBoolean(left == right, arena);
+    case ast::Operator::NotEqual:
+        return makeBoolean(left != right, arena);
+    case ast::Operator::Bang:
+        break;
+    }
+    return nullptr;
+}
+
+class Folder : public Rewriter
+{
+public:
+    explicit Folder(std::shared_ptr<ast::Arena> arena) :
+        m_arena{std::move(arena)}
+    {}
+
+    uint32_t folded() const {
+        return m_folded;
+    }
+
+private:
+    void rewrite(std::shared_ptr<ast::Expression>& slot) override {
+        if (auto folded = this->fold(slot.get())) {
+            slot = std::move(folded);
+            ++m_folded;
+        }
+    }
+
+    std::shared_ptr<ast::Expression> fold(ast::Expression* expression) {
+        if (const auto prefix = dynamic_cast<ast::PrefixExpression*>(expression)) {
+            const auto integer = dynamic_cast<ast::IntegerLiteral*>(prefix->right.get());
+            const auto boolean = dynamic_cast<ast::Boolean*>(prefix->right.get());
+            if (prefix->my_operator == ast::Operator::Bang) {
+                if (boolean) {
+                    return makeBoolean(!boolean->value, m_arena);
+                }
+                if (integer) {
+                    return makeBoolean(false, m_arena);
+                }
+            }
+            int64_t negated{};
+            if (prefix->my_operator == ast::Operator::Minus && integer && !__builtin_sub_overflow(0, integer->value, &negated)) {
+                return makeInteger(negated, m_arena);
+            }
+            return nullptr;
+        }
+
+        if (const auto infix = dynamic_cast<ast::InfixExpression*>(expression)) {
+            const auto leftInt = dynamic_cast<ast::IntegerLiteral*>(infix->left.get());
+            const auto rightInt = dynamic_cast<ast::IntegerLiteral*>(infix->right.get());
+            if (leftInt && rightInt) {
+                return foldInfix(infix->my_operator, leftInt->value, rightInt->value, m_arena);
+            }
+            const auto leftBool = dynamic_cast<ast::Boolean*>(infix->left.get());
+            const auto rightBool = dynamic_cast<ast::Boolean*>(infix->right.get());
+            if (leftBool && rightBool) {
+                if (infix->my_operator == ast::Operator::Equal) {
+                    return makeBoolean(leftBool->value == rightBool->value, m_arena);
+                }
+                if (infix->my_operator == ast::Operator::NotEqual) {
+                    return makeBoolean(leftBool->value != rightBool->value, m_arena);
+                }
+            }
+            return nullptr;
+        }
+
+        if (const auto ifExp = dynamic_cast<ast::IfExpression*>(expression)) {
+            std::optional<bool> truthy;
+            if (const auto boolean = dynamic_cast<ast::Boolean*>(ifExp->condition.get())) {
+                truthy = boolean->value;
+            } else if (dynamic_cast<ast::IntegerLiteral*>(ifExp->condition.get())) {
+                truthy = true;
+            }
+            if (!truthy) {
+                return nullptr;
+            }
+            const auto taken = singleExpression(*truthy ? ifExp->consequence.get() : ifExp->alternative.get());
+            if (!taken) {
+                return nullptr;
+            }
+            const auto& block = *truthy ? ifExp->consequence : ifExp->alternative;
+            return dynamic_cast<ast::ExpressionStatement*>(block->statements[0].get())->expression;
+        }
+
+        return nullptr;
+    }
+
+    uint32_t m_folded{};
+    std::shared_ptr<ast::Arena> m_arena;
+};
+
+uint32_t countNodes(const ast::Node* node);
+
+uint32_t countNodes(const ast::BlockStatement* block) {
+    return block ? countNodes(static_cast<const ast::Node*>(block)) : 0;
+}
+
+uint32_t countNodes(const ast::Node* node) {
+    if (!node) {
+        return 0;
+    }
+    if (const auto let = dynamic_cast<const ast::LetStatement*>(node)) {
+        return 2 + countNodes(let->value.get());
+    }
+    if (const auto ret = dynamic_cast<const ast::ReturnStatement*>(node)) {
+        return 1 + countNodes(ret->returnValue.get());
+    }
+    if (const auto exp = dynamic_cast<const ast::ExpressionStatement*>(node)) {
+        return 1 + countNodes(exp->expression.get());
+    }
+    if (const auto block = dynamic_cast<const ast::BlockStatement*>(node)) {
+        uint32_t count = 1;
+        for (const auto& statement : block->statements) {
+            count += countNodes(statement.get());
+        }
+        return count;
+    }
+    if (const auto prefix = dynamic_cast<const ast::PrefixExpression*>(node)) {
+        return 1 + countNodes(prefix->right.get());
+    }
+    if (const auto infix = dynamic_cast<const ast::InfixExpression*>(node)) {
+        return 1 + countNodes(infix->left.get()) + countNodes(infix->right.get());
+    }
+    if (const auto ifExp = dynamic_cast<const ast::IfExpression*>(node)) {
+        return 1 + countNodes(ifExp->condition.get()) + countNodes(ifExp->consequence.get()) +
+            countNodes(ifExp->alternative.get());
+    }
+    if (const auto literal = dynamic_cast<const ast::FunctionLteral*>(node)) {
+        return 1 + literal->parameters.size() + countNodes(literal->body.get());
+    }
+    if (const auto call = dynamic_cast<const ast::CallExpression*>(node)) {
+        uint32_t count = 1 + countNodes(call->function.get());
+        for (const auto& argument : call->arguments) {
+            count += countNodes(argument.get());
+        }
+        return count;
+    }
+    return 1;
+}
+
+class Eliminator : public Rewriter
+{
+public:
+    explicit Eliminator(const resolver::Resolution& resolution) :
+        m_resolution{resolution}
+    {
+        for (const auto identifier : resolution.late) {
+            m_lateReads.insert(identifier->symbol);
+        }
+    }
+
+    uint32_t removed() const {
+        return m_removed;
+    }
+
+private:
+    bool dead(const ast::Statement* statement) const {
+        if (const auto exp = dynamic_cast<const ast::ExpressionStatement*>(statement)) {
+            return safe(exp->expression.get(), m_resolution);
+        }
+        if (const auto let = dynamic_cast<const ast::LetStatement*>(statement)) {
+            const auto binding = m_resolution.Declaration(let);
+            return binding && binding->reads == 0 && !m_lateReads.contains(binding->symbol) &&
+                safe(let->value.get(), m_resolution);
+        }
+        return false;
+    }
+
+    // The last statement of a list is its value, so it always stays.
+    void rewriteStatements(std::vector<std::shared_ptr<ast::Statement>>& statements) override {
+        std::vector<std::shared_ptr<ast::Statement>> kept;
+        kept.reserve(statements.size());
+        for (std::size_t i = 0; i < statements.size(); ++i) {
+            const auto last = i + 1 == statements.size();
+            if (!last && this->dead(statements[i].get())) {
+                m_removed += countNodes(statements[i].get());
+                m_graveyard.push_back(std::move(statements[i]));
+                continue;
+            }
+            kept.push_back(std::move(statements[i]));
+            if (dynamic_cast<const ast::ReturnStatement*>(kept.back().get())) {
+                for (++i; i < statements.size(); ++i) {
+                    m_removed += countNodes(statements[i].get());
+                    m_graveyard.push_back(std::move(statements[i]));
+                }
+            }
+        }
+        statements = std::move(kept);
+    }
+
+    const resolver::Resolution& m_resolution;
+    std::unordered_set<symbols::Symbol> m_lateReads; // symbols of Resolution::late
+    uint32_t m_removed{};
+    std::vector<std::shared_ptr<ast::Statement>> m_graveyard;
+};
+
+// The arena new nodes of `program` go in, made for programs built by hand.
+const std::shared_ptr<ast::Arena>& arenaOf(ast::Program& program) {
+    if (!program.arena) {
+        program.arena = std::make_shared<ast::Arena>();
+    }
+    return program.arena;
+}
+
+} // namespace
+
+uint32_t optimizer::InlineCalls(ast::Program& program, const resolver::Resolution& resolution, uint32_t budget) {
+    auto inliner = Inliner{resolution, budget, arenaOf(program)};
+    inliner.Run(program);
+    return inliner.inlined();
+}
+
+uint32_t optimizer::FoldConstants(ast::Program& program) {
+    auto folder = Folder{arenaOf(program)};
+    folder.Run(program);
+    return folder.folded();
+}
+
+uint32_t optimizer::EliminateDeadCode(ast::Program& program) {
+    uint32_t removed{};
+    while (true) {
+        const auto resolution = resolver::Resolve(program);
+        auto eliminator = Eliminator{resolution};
+        eliminator.Run(program);
+        if (eliminator.removed() == 0) {
+            return removed;
+        }
+        removed += eliminator.removed();
+    }
+}
+
+optimizer::Stats optimizer::Optimize(ast::Program& program) {
+    Stats stats;
+    {
+        const stats::Scope scope{"inline"};
+        const auto resolution = resolver::Resolve(program);
+        stats.inlinedCalls = InlineCalls(program, resolution);
+    }
+    {
+        const stats::Scope scope{"fold"};
+        stats.foldedExpressions = FoldConstants(program);
+    }
+    {
+        const stats::Scope scope{"dead-code"};
+        stats.removedNodes = EliminateDeadCode(program);
+    }
+    return stats;
+}
@@ -0,0 +1,50 @@
+#ifndef optimizer_optimizer_h
+#define optimizer_optimizer_h
+
+#include <cstdint>
+
+#include <ast/ast.h>
+#include <resolver/resolver.h>
+
+namespace optimizer
+{
+
+// Largest callee body, in AST nodes, that InlineCalls will copy into a caller.
+inline constexpr uint32_t DefaultInlineBudget = 16;
+
+struct Stats {
+    uint32_t inlinedCalls{};
+    uint32_t foldedExpressions{};
+    uint32_t removedNodes{};
+};
+
+// Replaces a call with a copy of the callee's body when the callee is a
+// function literal bound once by a top-level let, is not recursive, and its
+// body is a single expression of at most `budget` nodes without nested
+// functions, lets or returns. Parameters are substituted by the argument
+// expressions: literals and identifiers may be duplicated, anything else must
+// be used exactly once, and arguments containing calls are never moved. A call
+// is left alone when a name used by the callee is shadowed at the call site.
+//
+// `resolution` must describe `program` as it was before this call.
+uint32_t InlineCalls(ast::Program& program, const resolver::Resolution& resolution, uint32_t budget = DefaultInlineBudget);
+
+// Evaluates integer and boolean operators whose operands are literals, and
+// if-expressions whose condition is a literal and whose taken branch is a
+// single expression. Integer overflow and division by zero are left for the
+// runtime to report.
+uint32_t FoldConstants(ast::Program& program);
+
+// Removes statements that cannot affect the result: everything after a return
+// in the same statement list, expression statements whose value is discarded
+// and let statements whose binding is never read, as long as the expression
+// involved can neither fail nor call anything. The last statement of a list is
+// its value and is always kept. Returns the number of AST nodes removed.
+uint32_t EliminateDeadCode(ast::Program& program);
+
+// Inlining, then constant folding, then dead code elimination.
+Stats Optimize(ast::Program& program);
+
+} // namespace optimizer
+
+#endif // optimizer_optimizer_h
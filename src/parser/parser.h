@@ -2,18 +2,19 @@
 #define parser_parser_h
 
 #include <functional>
-#include <charconv>
 
 #include <fmt/core.h>
 
+#include <ast/arena.h>
 #include <ast/ast.h>
 #include <lexer/lexer.h>
+#include <lexer/token_stream.h>
+#include <symbols/symbols.h>
 #include <token/token.h>
 
 struct Parser;
 
 using prefixParseFn = std::function<std::shared_ptr<ast::Expression>(Parser*)>;
-using infixParseFn = std::function<std::shared_ptr<ast::Expression>(Parser*, std::shared_ptr<ast::Expression>)>;
 
 enum class Priority {
     Lowest,
@@ -25,6 +26,13 @@ enum class Priority {
     Call
 };
 
+// Tokens the parser may look at beyond the current one.
+inline constexpr std::size_t TokenLookahead = 4;
+
+// Blocks (if and function bodies) are still parsed recursively, so their
+// nesting is limited; expressions nest as deep as memory allows.
+inline constexpr std::size_t MaxBlockDepth = 1024;
+
 inline const auto precedences = std::unordered_map<std::string_view, Priority>{
     {token::EQ, Priority::Equals},
     {token::NOT_EQ, Priority::Equals},
@@ -38,54 +46,81 @@ inline const auto precedences = std::unordered_map<std::string_view, Priority>{
 };
 
 struct Parser {
-    Parser(lexer::Lexer lexer) : l(std::move(lexer)) {
-        this->nextToken();
+    Parser(lexer::Lexer lexer, std::size_t arenaChunkSize = ast::Arena::DefaultChunkSize) :
+        tokens(std::move(lexer)),
+        arena(std::make_shared<ast::Arena>(arenaChunkSize))
+    {
         this->nextToken();
 
         this->registerPrefix(token::IDENT, &Parser::parseIdentifier);
         this->registerPrefix(token::INT, &Parser::parseIntegerLiteral);
-        this->registerPrefix(token::BANG, &Parser::parsePrefixExpression);
-        this->registerPrefix(token::MINUS, &Parser::parsePrefixExpression);
         this->registerPrefix(token::TRUE, &Parser::parseBoolean);
         this->registerPrefix(token::FALSE, &Parser::parseBoolean);
-        this->registerPrefix(token::LPAREN, &Parser::parseGroupedExpression);
         this->registerPrefix(token::IF, &Parser::parseIfExpression);
         this->registerPrefix(token::FUNCTION, &Parser::parseFunctionLiteral);
+    }
 
-        this->registerInfix(token::PLUS, &Parser::parseInfixExpression);
-        this->registerInfix(token::MINUS, &Parser::parseInfixExpression);
-        this->registerInfix(token::SLASH, &Parser::parseInfixExpression);
-        this->registerInfix(token::ASTERISK, &Parser::parseInfixExpression);
-        this->registerInfix(token::EQ, &Parser::parseInfixExpression);
-        this->registerInfix(token::NOT_EQ, &Parser::parseInfixExpression);
-        this->registerInfix(token::LT, &Parser::parseInfixExpression);
-        this->registerInfix(token::GT, &Parser::parseInfixExpression);
-        this->registerInfix(token::LPAREN, &Parser::parseCallExpression);
+    template <typename T>
+    std::shared_ptr<T> makeNode() {
+        return ast::MakeNode<T>(this->arena);
     }
 
     std::shared_ptr<ast::Expression> parseIdentifier() {
-        auto ident = std::make_shared<ast::Identifier>();
-        ident->token = this->curToken;
-        ident->value = this->curToken.literal;
+        auto ident = this->makeNode<ast::Identifier>();
+        ident->symbol = this->curSymbol();
+        ident->value = symbols::Name(ident->symbol);
         return ident;
     }
 
     void nextToken() {
-        this->curToken = this->peekToken;
-        this->peekToken = this->l.NextToken();
+        this->curToken = this->tokens.Next();
+
+        const auto& lexerErrors = this->tokens.Errors();
+        if (this->lexerErrors < lexerErrors.size()) {
+            this->errors.insert(this->errors.end(), lexerErrors.begin() + this->lexerErrors, lexerErrors.end());
+            this->lexerErrors = lexerErrors.size();
+        }
     }
 
     ast::Program ParseProgram() {
         ast::Program program;
+        program.arena = this->arena;
 
-        while (this->curToken.type != token::eof) {
-            const auto stmt = this->parseStatement();
-            program.statements.push_back(stmt);
-            this->nextToken();
+        while (auto stmt = this->ParseNextStatement()) {
+            program.statements.push_back(std::move(stmt));
         }
         return program;
     }
 
+    bool AtEnd() const {
+        return this->curToken.type == token::eof;
+    }
+
+    // Parses the next well-formed top-level statement, reading only as much
+    // input as it needs, so that statements can be handled while the rest is
+    // still arriving; nullptr once the input is exhausted. Statements with
+    // syntax errors are reported and skipped. Once the caller has dropped every
+    // statement returned so far their arena chunks are reused, which bounds
+    // memory by the largest statement.
+    std::shared_ptr<ast::Statement> ParseNextStatement() {
+        while (!this->AtEnd()) {
+            if (this->arena.use_count() == 1) {
+                this->arena->release();
+            }
+            const auto syntaxErrors = this->syntaxErrors;
+            auto stmt = this->parseStatement();
+            const auto failed = this->syntaxErrors != syntaxErrors;
+            if (failed) {
+                this->synchronize();
+            }
+            this->nextToken();
+            if (!failed) {
+                return stmt;
+            }
+        }
+        return {};
+    }
+
     const std::vector<std::string>& Errors() const {
         return this->errors;
     }
@@ -101,36 +136,38 @@ struct Parser {
     }
 
     std::shared_ptr<ast::Statement> parseLetStatement() {
-        auto stmt = std::make_shared<ast::LetStatement>();
-        stmt->token = this->curToken;
+        auto stmt = this->makeNode<ast::LetStatement>();
 
         if (!this->expectPeek(token::IDENT)) {
             return {};
         }
 
         stmt->name = ast::Identifier{};
-        stmt->name.token = this->curToken;
-        stmt->name.value = this->curToken.literal;
+        stmt->name.symbol = this->curSymbol();
+        stmt->name.value = symbols::Name(stmt->name.symbol);
         
         if (!this->expectPeek(token::ASSIGN)) {
             return {};
         }
 
-        
+        this->nextToken();
+
+        stmt->value = this->parseExpression(Priority::Lowest);
 
-        while (!this->curTokenIs(token::SEMICOLON)) {
+        if (this->peekTokenIs(token::SEMICOLON)) {
             this->nextToken();
         }
         return stmt;
     }
 
     std::shared_ptr<ast::Statement> parseReturnStatement() {
-        auto stmt = std::make_shared<ast::ReturnStatement>();
-        stmt->token = this->curToken;
+        auto stmt = this->makeNode<ast::ReturnStatement>();
 
         this->nextToken();
 
-        while (!this->curTokenIs(token::SEMICOLON)) {
+        stmt->returnValue = this->parseExpression(Priority::Lowest);
+
+        if (this->peekTokenIs(token::SEMICOLON)) {
             this->nextToken();
         }
 
@@ -138,8 +175,7 @@ struct Parser {
     }
     
     std::shared_ptr<ast::Statement> parseExpressionStatement() {
-        auto stmt = std::make_shared<ast::ExpressionStatement>();
-        stmt->token = this->curToken;
+        auto stmt = this->makeNode<ast::ExpressionStatement>();
 
         stmt->expression = this->parseExpression(Priority::Lowest);
 
@@ -150,99 +186,178 @@ struct Parser {
         return stmt;
     }
 
+    // Operators that still wait for their right operand, innermost last.
+    struct PendingOperator {
+        enum class Kind {
+            Prefix,
+            Infix,
+            Group,
+            Call,
+        };
+
+        Kind kind;
+        Priority precedence;
+        std::shared_ptr<ast::Expression> node;
+    };
+
+    // Pratt parsing with the recursion replaced by an explicit stack, so that
+    // prefix operators, parentheses, operator chains and call arguments nest
+    // as deep as heap memory allows.
     std::shared_ptr<ast::Expression> parseExpression(Priority precedence) {
-        auto prefix = this->prefixParseFns[this->curToken.type];
-        if (!prefix) {
-            this->noPrefixParseFnError(this->curToken.type);
-            return {};
-        }
-        auto leftExp = std::invoke(prefix, this);
-
-        while (!this->peekTokenIs(token::SEMICOLON) && precedence < this->peekPrecedence()) {
-            auto infix = this->infixParseFns[this->peekToken.type];
-            if (!infix) {
-                return leftExp;
+        std::vector<PendingOperator> pending;
+        for (;;) {
+            while (this->curTokenIs(token::BANG) || this->curTokenIs(token::MINUS) || this->curTokenIs(token::LPAREN)) {
+                if (this->curTokenIs(token::LPAREN)) {
+                    pending.push_back({PendingOperator::Kind::Group, Priority::Lowest, {}});
+                } else {
+                    auto expression = this->makeNode<ast::PrefixExpression>();
+                    expression->my_operator = ast::OperatorOf(this->curToken.type);
+                    pending.push_back({PendingOperator::Kind::Prefix, Priority::Prefix, std::move(expression)});
+                }
+                this->nextToken();
             }
 
-            this->nextToken();
+            std::shared_ptr<ast::Expression> leftExp;
+            auto prefix = this->prefixParseFns[this->curToken.type];
+            if (prefix) {
+                leftExp = std::invoke(prefix, this);
+            } else {
+                this->noPrefixParseFnError(this->curToken.type);
+            }
 
-            leftExp = std::invoke(infix, this, leftExp);
+            // A missing operand ends its own level without taking operators.
+            bool extend = static_cast<bool>(prefix);
+            for (;;) {
+                const auto bound = pending.empty() ? precedence : pending.back().precedence;
+                if (extend && !this->peekTokenIs(token::SEMICOLON) && bound < this->peekPrecedence()) {
+                    this->nextToken();
+                    if (this->curTokenIs(token::LPAREN)) {
+                        auto call = this->makeNode<ast::CallExpression>();
+                        call->function = std::move(leftExp);
+                        if (this->peekTokenIs(token::RPAREN)) {
+                            this->nextToken();
+                            leftExp = std::move(call);
+                            continue;
+                        }
+                        pending.push_back({PendingOperator::Kind::Call, Priority::Lowest, std::move(call)});
+                    } else {
+                        auto infix = this->makeNode<ast::InfixExpression>();
+                        infix->my_operator = ast::OperatorOf(this->curToken.type);
+                        infix->left = std::move(leftExp);
+                        pending.push_back({PendingOperator::Kind::Infix, this->curPrecedence(), std::move(infix)});
+                    }
+                    this->nextToken();
+                    break;
+                }
+                extend = true;
+
+                if (pending.empty()) {
+                    return leftExp;
+                }
+                auto top = std::move(pending.back());
+                pending.pop_back();
+                if (top.kind == PendingOperator::Kind::Prefix) {
+                    static_cast<ast::PrefixExpression&>(*top.node).right = std::move(leftExp);
+                    leftExp = std::move(top.node);
+                } else if (top.kind == PendingOperator::Kind::Infix) {
+                    static_cast<ast::InfixExpression&>(*top.node).right = std::move(leftExp);
+                    leftExp = std::move(top.node);
+                } else if (top.kind == PendingOperator::Kind::Group) {
+                    if (!this->expectPeek(token::RPAREN)) {
+                        leftExp = {};
+                    }
+                } else {
+                    auto& call = static_cast<ast::CallExpression&>(*top.node);
+                    call.arguments.push_back(std::move(leftExp));
+                    if (this->peekTokenIs(token::COMMA)) {
+                        this->nextToken();
+                        this->nextToken();
+                        pending.push_back(std::move(top));
+                        break;
+                    }
+                    if (!this->expectPeek(token::RPAREN)) {
+                        call.arguments.clear();
+                    }
+                    leftExp = std::move(top.node);
+                }
+            }
         }
-        return leftExp;
     }
 
     std::shared_ptr<ast::Expression> parseIntegerLiteral() {
-        auto lit = std::make_shared<ast::IntegerLiteral>();
-        lit->token = this->curToken;
+        auto lit = this->makeNode<ast::IntegerLiteral>();
 
-        int64_t value{};
-        std::from_chars(this->curToken.literal.data(), this->curToken.literal.data() + this->curToken.literal.size(), value);
-        
-        lit->value = value;
+        lit->value = this->curToken.value;
         return lit;
     }
 
-    std::shared_ptr<ast::Expression> parsePrefixExpression() {
-        auto expression = std::make_shared<ast::PrefixExpression>();
-        expression->token = this->curToken;
-        expression->my_operator = this->curToken.literal;
-
-        this->nextToken();
-
-        expression->right = this->parseExpression(Priority::Prefix);
-
-        return expression;
-    }
-
-    std::shared_ptr<ast::Expression> parseInfixExpression(std::shared_ptr<ast::Expression> left) {
-        auto expression = std::make_shared<ast::InfixExpression>();
-        expression->token = this->curToken;
-        expression->my_operator = this->curToken.literal;
-        expression->left = left;
-
-        const auto precedence = this->curPrecedence();
-        this->nextToken();
-        expression->right = this->parseExpression(precedence);
-
-        return expression;
-    }
-
     std::shared_ptr<ast::Expression> parseBoolean() {
-        auto expression = std::make_shared<ast::Boolean>();
-        expression->token = this->curToken;
+        auto expression = this->makeNode<ast::Boolean>();
         expression->value = this->curTokenIs(token::TRUE);
         return expression;
     }
 
-    std::shared_ptr<ast::Expression> parseGroupedExpression() {
-        this->nextToken();
+    std::shared_ptr<ast::BlockStatement> parseBlockStatement() {
+        auto block = this->makeNode<ast::BlockStatement>();
 
-        auto exp = this->parseExpression(Priority::Lowest);
-        if (!this->expectPeek(token::RPAREN)) {
-            return {};
+        if (this->blockDepth == MaxBlockDepth) {
+            this->error(this->curToken.offset, fmt::format("blocks nested deeper than {}", MaxBlockDepth));
+            this->skipBlock();
+            return block;
         }
-        return exp;
-    }
+        ++this->blockDepth;
 
-    std::shared_ptr<ast::BlockStatement> parseBlockStatement() {
-        auto block = std::make_shared<ast::BlockStatement>();
-        block->token = this->curToken;
-        
         this->nextToken();
 
         while (!this->curTokenIs(token::RBRACE) && !this->curTokenIs(token::eof)) {
+            const auto syntaxErrors = this->syntaxErrors;
             auto stmt = this->parseStatement();
-            if (stmt.get()) {
+            if (this->syntaxErrors == syntaxErrors) {
                 block->statements.push_back(std::move(stmt));
+            } else {
+                this->synchronize();
             }
             this->nextToken();
         }
+        --this->blockDepth;
         return block;
     }
 
+    // Panic mode: after a syntax error, skips to the last token of the broken
+    // statement, which is a ';' or the token before 'let', 'return' or an
+    // unmatched '}', so that parsing resumes at a statement boundary instead
+    // of reporting errors that only follow from the first one.
+    void synchronize() {
+        std::size_t depth = 0;
+        while (!this->curTokenIs(token::eof)) {
+            if (this->curTokenIs(token::LBRACE)) {
+                ++depth;
+            } else if (this->curTokenIs(token::RBRACE) && depth > 0) {
+                --depth;
+            }
+            if (depth == 0 && (this->curTokenIs(token::SEMICOLON) || this->peekTokenIs(token::LET) ||
+                               this->peekTokenIs(token::RETURN) || this->peekTokenIs(token::RBRACE) ||
+                               this->peekTokenIs(token::eof))) {
+                return;
+            }
+            this->nextToken();
+        }
+    }
+
+    // Moves from a '{' to its matching '}' without building anything.
+    void skipBlock() {
+        for (std::size_t open = 1; open > 0 && !this->peekTokenIs(token::eof);) {
+            this->nextToken();
+            if (this->curTokenIs(token::LBRACE)) {
+                ++open;
+            } else if (this->curTokenIs(token::RBRACE)) {
+                --open;
+            }
+        }
+    }
+
     std::shared_ptr<ast::Expression> parseIfExpression() {
-        auto expression = std::make_shared<ast::IfExpression>();
-        expression->token = this->curToken;
+        auto expression = this->makeNode<ast::IfExpression>();
 
         if (!this->expectPeek(token::LPAREN)) {
             return {};
@@ -282,17 +397,17 @@ struct Parser {
 
         this->nextToken();
 
-        auto ident = std::make_shared<ast::Identifier>();
-        ident->token = this->curToken;
-        ident->value = this->curToken.literal;
+        auto ident = this->makeNode<ast::Identifier>();
+        ident->symbol = this->curSymbol();
+        ident->value = symbols::Name(ident->symbol);
         identifiers.push_back(std::move(ident));
 
         while (this->peekTokenIs(token::COMMA)) {
             this->nextToken();
             this->nextToken();
-            ident = std::make_shared<ast::Identifier>();
-            ident->token = this->curToken;
-            ident->value = this->curToken.literal;
+            ident = this->makeNode<ast::Identifier>();
+            ident->symbol = this->curSymbol();
+            ident->value = symbols::Name(ident->symbol);
             identifiers.push_back(std::move(ident));
         }
 
@@ -304,8 +419,10 @@ struct Parser {
     }
 
     std::shared_ptr<ast::Expression> parseFunctionLiteral() {
-        auto lit = std::make_shared<ast::FunctionLteral>();
-        lit->token = this->curToken;
+        auto lit = this->makeNode<ast::FunctionLteral>();
+        const auto [line, column] = this->tokens.Locate(this->curToken.offset);
+        lit->line = line;
+        lit->column = column;
 
         if (!this->expectPeek(token::LPAREN)) {
             return {};
@@ -322,40 +439,17 @@ struct Parser {
         return lit;
     }
 
-    std::vector<std::shared_ptr<ast::Expression>> parseCallArguments() {
-        auto args = std::vector<std::shared_ptr<ast::Expression>>{};
-
-        if (this->peekTokenIs(token::RPAREN)) {
-            this->nextToken();
-            return args;
-        }
-
-        this->nextToken();
-        args.push_back(this->parseExpression(Priority::Lowest));
-
-        while (this->peekTokenIs(token::COMMA)) {
-            this->nextToken();
-            this->nextToken();
-            args.push_back(this->parseExpression(Priority::Lowest));
-        }
-
-        if (!this->expectPeek(token::RPAREN)) {
-            return {};
-        }
-
-        return args;
-    }
-
-    std::shared_ptr<ast::Expression> parseCallExpression(std::shared_ptr<ast::Expression> function) {
-        auto exp = std::make_shared<ast::CallExpression>();
-        exp->token = this->curToken;
-        exp->function = function;
-        exp->arguments = this->parseCallArguments();
-        return exp;
+    void noPrefixParseFnError(std::string_view t) {
+        this->error(this->curToken.offset, fmt::format("no prefix parse function for {} found", t));
     }
 
-    void noPrefixParseFnError(std::string_view t) {
-        this->errors.emplace_back(fmt::format("no prefix parse function for {} found", t));
+    // The lexer interns identifiers; anything else that ends up where a name
+    // belongs, after a syntax error, is interned here.
+    symbols::Symbol curSymbol() {
+        if (this->curTokenIs(token::IDENT)) {
+            return static_cast<symbols::Symbol>(this->curToken.value);
+        }
+        return symbols::Intern(this->curToken.literal);
     }
 
     bool curTokenIs(std::string_view t) {
@@ -363,7 +457,7 @@ struct Parser {
     }
 
     bool peekTokenIs(std::string_view t) {
-        return this->peekToken.type == t;
+        return this->tokens.Peek().type == t;
     }
 
     bool expectPeek(std::string_view t) {
@@ -375,21 +469,24 @@ struct Parser {
         return false;
     }
 
+    // Errors start with the line and column of the token they are about.
+    void error(uint32_t offset, std::string_view message) {
+        ++this->syntaxErrors;
+        const auto [line, column] = this->tokens.Locate(offset);
+        this->errors.emplace_back(fmt::format("{}:{}: {}", line, column, message));
+    }
+
     void peekError(std::string_view t) {
-        this->errors.emplace_back(fmt::format("expected next token to be {}, got {} instead", t, this->peekToken.type));
+        this->error(this->tokens.Peek().offset, fmt::format("expected next token to be {}, got {} instead", t, this->tokens.Peek().type));
     }
 
 
-    void registerPrefix(std::string tokenType, prefixParseFn fn) {
+    void registerPrefix(std::string_view tokenType, prefixParseFn fn) {
         this->prefixParseFns[std::move(tokenType)] = fn;
     }
 
-    void registerInfix(std::string tokenType, infixParseFn fn) {
-        this->infixParseFns[std::move(tokenType)] = fn;
-    }
-
     Priority peekPrecedence() {
-        const auto it = precedences.find(this->peekToken.type);
+        const auto it = precedences.find(this->tokens.Peek().type);
         if (it != precedences.end()) {
             return it->second;
         }
@@ -404,13 +501,15 @@ struct Parser {
         return Priority::Lowest;
     } 
 
-    lexer::Lexer l;
+    lexer::TokenStream<TokenLookahead> tokens;
+    std::shared_ptr<ast::Arena> arena;
     token::Token curToken;
-    token::Token peekToken;
     std::vector<std::string> errors;
+    std::size_t lexerErrors{}; // how many of tokens.Errors() are already in errors
+    std::size_t syntaxErrors{}; // errors reported by the parser itself
+    std::size_t blockDepth{};
 
-    std::unordered_map<std::string, prefixParseFn> prefixParseFns;
-    std::unordered_map<std::string, infixParseFn> infixParseFns;
+    std::unordered_map<std::string_view, prefixParseFn> prefixParseFns;
 };
 
 #endif // parser_parser_h
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "purity.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+
+// Identifiers read anywhere inside a node, nested functions included.
+void collectIdentifiers(const ast::Node* node, std::vector<const ast::Identifier*>& identifiers) {
+    if (!node) {
+        return;
+    }
+    if (const auto identifier = dynamic_cast<const ast::Identifier*>(node)) {
+        identifiers.push_back(identifier);
+    } else if (const auto let = dynamic_cast<const ast::LetStatement*>(node)) {
+        collectIdentifiers(let->value.get(), identifiers);
+    } else if (const auto ret = dynamic_cast<const ast::ReturnStatement*>(node)) {
+        collectIdentifiers(ret->returnValue.get(), identifiers);
+    } else if (const auto exp = dynamic_cast<const ast::ExpressionStatement*>(node)) {
+        collectIdentifiers(exp->expression.get(), identifiers);
+    } else if (const auto block = dynamic_cast<const ast::BlockStatement*>(node)) {
+        for (const auto& statement : block->statements) {
+            collectIdentifiers(statement.get(), identifiers);
+        }
+    } else if (const auto prefix = dynamic_cast<const ast::PrefixExpression*>(node)) {
+        collectIdentifiers(prefix->right.get(), identifiers);
+    } else if (const auto infix = dynamic_cast<const ast::InfixExpression*>(node)) {
+        collectIdentifiers(infix->left.get(), identifiers);
+        collectIdentifiers(infix->right.get(), identifiers);
+    } else if (const auto ifExp = dynamic_cast<const ast::IfExpression*>(node)) {
+        collectIdentifiers(ifExp->condition.get(), identifiers);
+        collectIdentifiers(ifExp->consequence.get(), identifiers);
+        collectIdentifiers(ifExp->alternative.get(), identifiers);
+    } else if (const auto literal = dynamic_cast<const ast::FunctionLteral*>(node)) {
+        collectIdentifiers(literal->body.get(), identifiers);
+    } else if (const auto call = dynamic_cast<const ast::CallExpression*>(node)) {
+        collectIdentifiers(call->function.get(), identifiers);
+        for (const auto& argument : call->arguments) {
+            collectIdentifiers(argument.get(), identifiers);
+        }
+    }
+}
+
+bool within(const resolver::FunctionInfo* function, const resolver::FunctionInfo* outer) {
+    for (; function; function = function->parent) {
+        if (function == outer) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+purity::Analysis purity::Analyze(const ast::Program& program, const resolver::Resolution& resolution) {
+    std::unordered_map<const resolver::Binding*, const ast::Expression*> globalValues;
+    std::unordered_map<symbols::Symbol, const resolver::Binding*> globalsBySymbol;
+    for (const auto& statement : program.statements) {
+        if (const auto let = dynamic_cast<const ast::LetStatement*>(statement.get())) {
+            if (const auto binding = resolution.Declaration(let)) {
+                globalValues[binding] = let->value.get();
+            }
+        }
+    }
+    for (const auto binding : resolution.globals) {
+        globalsBySymbol.emplace(binding->symbol, binding);
+    }
+
+    struct Candidate {
+        const resolver::FunctionInfo* function;
+        std::vector<const resolver::Binding*> outerReads; // nullptr for names that never resolve
+    };
+    std::vector<Candidate> candidates;
+    Analysis result;
+    for (const auto& function : resolution.functions) {
+        std::vector<const ast::Identifier*> identifiers;
+        collectIdentifiers(function.literal->body.get(), identifiers);
+
+        Candidate candidate{&function, {}};
+        for (const auto identifier : identifiers) {
+            auto binding = resolution.Use(identifier);
+            if (!binding) {
+                // A global let later in the program is still found at run time.
+                const auto it = globalsBySymbol.find(identifier->symbol);
+                binding = it == globalsBySymbol.end() ? nullptr : it->second;
+            }
+            if (!binding || !within(binding->owner, &function)) {
+                candidate.outerReads.push_back(binding);
+            }
+        }
+        candidates.push_back(std::move(candidate));
+        result.pure.insert(function.literal);
+    }
+
+    // Start from "everything is pure" and strike out functions until stable,
+    // so that mutually recursive pure functions stay pure.
+    const auto stable = [&](const resolver::Binding* binding) {
+        if (!binding || binding->owner || binding->declarations != 1) {
+            return false;
+        }
+        const auto value = globalValues[binding];
+        if (dynamic_cast<const ast::IntegerLiteral*>(value) || dynamic_cast<const ast::Boolean*>(value)) {
+            return true;
+        }
+        const auto literal = dynamic_cast<const ast::FunctionLteral*>(value);
+        return literal && result.pure.contains(literal);
+    };
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (const auto& candidate : candidates) {
+            if (!result.pure.contains(candidate.function->literal)) {
+                continue;
+            }
+            for (const auto binding : candidate.outerReads) {
+                if (!stable(binding)) {
+                    result.pure.erase(candidate.function->literal);
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    for (const auto& candidate : candidates) {
+        const auto literal = candidate.function->literal;
+        if (!result.pure.contains(literal)) {
+            continue;
+        }
+        for (const auto binding : candidate.outerReads) {
+            if (binding && binding->function == literal && !binding->owner && binding->declarations == 1) {
+                result.memoizable.insert(literal);
+                break;
+            }
+        }
+    }
+    return result;
+}
@@ -0,0 +1,37 @@
+#ifndef purity_purity_h
+#define purity_purity_h
+
+#include <unordered_set>
+
+#include <ast/ast.h>
+#include <resolver/resolver.h>
+
+namespace purity
+{
+
+struct Analysis {
+    bool Pure(const ast::FunctionLteral* function) const {
+        return this->pure.contains(function);
+    }
+
+    bool Memoizable(const ast::FunctionLteral* function) const {
+        return this->memoizable.contains(function);
+    }
+
+    std::unordered_set<const ast::FunctionLteral*> pure;
+    std::unordered_set<const ast::FunctionLteral*> memoizable;
+};
+
+// A function is pure when its result depends on nothing but its arguments:
+// every name it reads from outside its own body is a top-level binding that is
+// let exactly once, to a literal or to another pure function. Unknown names,
+// which includes every builtin, make a function impure.
+//
+// Memoizable functions are the pure ones bound by such a top-level let that
+// refer to themselves, i.e. recursive ones, where caching results by argument
+// value pays off.
+Analysis Analyze(const ast::Program& program, const resolver::Resolution& resolution);
+
+} // namespace purity
+
+#endif // purity_purity_h
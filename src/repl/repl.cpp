@@ -1,21 +1,47 @@
 #include "repl.h"
 
 #include <iostream>
+#include <string>
+#include <string_view>
+#include <variant>
 
-#include <lexer/lexer.h>
+#include <script/script.h>
 
 void repl::Start() {
+    // Globals and the code of earlier lines; each line is built on its own
+    // against them rather than replayed with everything typed before it.
+    // Unoptimized code builds fastest, which is what a prompt waits on.
+    // Every piece keeps a shadow stack so that `:profile <line>` can show the
+    // functions of earlier lines too.
+    script::Session session{{.flags = "-O0", .profile = true}};
+    constexpr std::string_view profile = ":profile ";
+    std::vector<std::string> errors;
+    std::string folded;
+    std::string out;
+    std::string line;
     while (true) {
-        std::cout << ">> ";
-        std::string line;
-        std::getline(std::cin, line);
-        if (line.empty()) {
+        std::cout << ">> " << std::flush;
+        if (!std::getline(std::cin, line)) {
             return;
         }
 
-        auto lexer = lexer::Lexer(std::move(line));
-        for (auto tok = lexer.NextToken(); tok.type != token::eof; tok = lexer.NextToken()) {
-            std::cout << tok.type << ' ' << tok.literal << std::endl;
+        out.clear();
+        errors.clear();
+        folded.clear();
+        const auto result = line.starts_with(profile)
+                                 ? session.Profile(std::string_view{line}.substr(profile.size()), errors, folded)
+                                 : session.Run(line, errors);
+        if (!result) {
+            for (const auto& error : errors) {
+                out += '\t' + error + '\n';
+            }
+        } else if (!result->error.empty()) {
+            out += "ERROR: " + result->error + '\n';
+        } else if (!std::holds_alternative<script::Null>(result->value)) {
+            out += script::Inspect(result->value) + '\n';
         }
+        out += folded;
+        // One write per line rather than a flush per statement.
+        std::cout << out;
     }
-} 
\ No newline at end of file
+}
@@ -0,0 +1,304 @@
+#include "resolver.h"
+
+#include <unordered_set>
+#include <utility>
+
+namespace
+{
+
+using resolver::Binding;
+using resolver::FunctionInfo;
+using resolver::Storage;
+
+class Resolver
+{
+public:
+    Resolver(resolver::Resolution& result, resolver::Session* session) :
+        m_result{result},
+        m_session{session}
+    {
+        // The global scope of a session is its own table, not a copy.
+        m_scopes.emplace_back();
+        if (session) {
+            session->undoGlobals = session->globals.size();
+            session->undoBindings.clear();
+            session->undoFunctions.clear();
+            for (auto& binding : session->globals) {
+                m_result.globals.push_back(&binding);
+            }
+        }
+    }
+
+    void Run(const ast::Program& program) {
+        for (const auto& statement : program.statements) {
+            this->statement(statement.get(), false);
+            const auto let = dynamic_cast<const ast::LetStatement*>(statement.get());
+            if (m_session && let && dynamic_cast<const ast::FunctionLteral*>(let->value.get())) {
+                auto& function = m_session->functions[m_result.declarations.at(let)];
+                m_session->undoFunctions.emplace(m_result.declarations.at(let), function);
+                function = statement;
+            }
+        }
+        this->captureLate();
+        this->markLetBoundEscapes();
+        this->markBoxed();
+        this->assignSlots();
+    }
+
+private:
+    struct Scope {
+        FunctionInfo* function{};
+        std::unordered_map<symbols::Symbol, Binding*> names;
+    };
+
+    struct Capture {
+        Binding* binding;
+        FunctionInfo* reader;
+    };
+
+    struct LateUse {
+        const ast::Identifier* identifier;
+        FunctionInfo* reader;
+        bool callee;
+    };
+
+    std::unordered_map<symbols::Symbol, Binding*>& names(Scope& scope) {
+        return !scope.function && m_session ? m_session->names : scope.names;
+    }
+
+    // Logs the state of a global of an earlier piece before it changes.
+    void touch(Binding* binding) {
+        if (m_session && !binding->owner && binding->slot < m_session->undoGlobals) {
+            m_session->undoBindings.emplace(binding, *binding);
+        }
+    }
+
+    Binding* declare(const ast::Identifier& name) {
+        auto& scope = m_scopes.back();
+        auto& names = this->names(scope);
+        if (const auto it = names.find(name.symbol); it != names.end()) {
+            this->touch(it->second);
+            ++it->second->declarations;
+            return it->second;
+        }
+
+        const auto global = !scope.function;
+        auto& binding = global && m_session ? m_session->globals.emplace_back() : m_result.bindings.emplace_back();
+        binding.name = name.value;
+        binding.symbol = name.symbol;
+        binding.owner = scope.function;
+        binding.declarations = 1;
+        if (scope.function) {
+            scope.function->locals.push_back(&binding);
+        } else {
+            binding.storage = Storage::Global;
+            binding.slot = m_result.globals.size();
+            m_result.globals.push_back(&binding);
+        }
+        names.emplace(name.symbol, &binding);
+        return &binding;
+    }
+
+    void use(const ast::Identifier* identifier, bool callee) {
+        for (auto scope = m_scopes.rbegin(); scope != m_scopes.rend(); ++scope) {
+            auto& names = this->names(*scope);
+            const auto it = names.find(identifier->symbol);
+            if (it == names.end()) {
+                continue;
+            }
+
+            auto binding = it->second;
+            this->touch(binding);
+            ++binding->reads;
+            if (callee) {
+                ++binding->calls;
+            }
+            if (binding->owner != m_scopes.back().function) {
+                binding->captured = true;
+                m_captures.push_back({binding, m_scopes.back().function});
+            }
+            m_result.uses.emplace(identifier, binding);
+            return;
+        }
+        if (m_scopes.size() == 1) {
+            m_result.unbound.push_back(identifier);
+        } else {
+            m_result.late.push_back(identifier);
+            m_lateUses.push_back({identifier, m_scopes.back().function, callee});
+        }
+    }
+
+    // `tail` is set for statements whose value can flow out of their block.
+    void statement(const ast::Statement* statement, bool tail) {
+        if (const auto let = dynamic_cast<const ast::LetStatement*>(statement)) {
+            if (const auto literal = dynamic_cast<const ast::FunctionLteral*>(let->value.get())) {
+                auto binding = this->declare(let->name);
+                binding->function = literal;
+                m_result.declarations.emplace(let, binding);
+                m_letBound.emplace_back(this->function(literal, false), binding);
+                return;
+            }
+            this->expression(let->value.get(), true);
+            m_result.declarations.emplace(let, this->declare(let->name));
+        } else if (const auto ret = dynamic_cast<const ast::ReturnStatement*>(statement)) {
+            this->expression(ret->returnValue.get(), true);
+        } else if (const auto exp = dynamic_cast<const ast::ExpressionStatement*>(statement)) {
+            this->expression(exp->expression.get(), tail);
+        } else if (const auto block = dynamic_cast<const ast::BlockStatement*>(statement)) {
+            this->block(block);
+        }
+    }
+
+    void block(const ast::BlockStatement* block) {
+        if (!block) {
+            return;
+        }
+        for (std::size_t i = 0; i < block->statements.size(); ++i) {
+            this->statement(block->statements[i].get(), i + 1 == block->statements.size());
+        }
+    }
+
+    // `escapes` is set when the value of the expression may be stored or
+    // returned rather than only consumed by an operator or a call.
+    void expression(const ast::Expression* expression, bool escapes) {
+        if (const auto identifier = dynamic_cast<const ast::Identifier*>(expression)) {
+            this->use(identifier, false);
+        } else if (const auto prefix = dynamic_cast<const ast::PrefixExpression*>(expression)) {
+            this->expression(prefix->right.get(), false);
+        } else if (const auto infix = dynamic_cast<const ast::InfixExpression*>(expression)) {
+            this->expression(infix->left.get(), false);
+            this->expression(infix->right.get(), false);
+        } else if (const auto ifExp = dynamic_cast<const ast::IfExpression*>(expression)) {
+            this->expression(ifExp->condition.get(), false);
+            this->block(ifExp->consequence.get());
+            this->block(ifExp->alternative.get());
+        } else if (const auto literal = dynamic_cast<const ast::FunctionLteral*>(expression)) {
+            this->function(literal, escapes);
+        } else if (const auto call = dynamic_cast<const ast::CallExpression*>(expression)) {
+            if (const auto callee = dynamic_cast<const ast::Identifier*>(call->function.get())) {
+                this->use(callee, true);
+            } else {
+                this->expression(call->function.get(), false);
+            }
+            for (const auto& argument : call->arguments) {
+                this->expression(argument.get(), true);
+            }
+        }
+    }
+
+    FunctionInfo* function(const ast::FunctionLteral* literal, bool escapes) {
+        auto& info = m_result.functions.emplace_back();
+        info.literal = literal;
+        info.parent = m_scopes.back().function;
+        info.escapes = escapes || !info.parent;
+        m_result.byLiteral.emplace(literal, &info);
+
+        m_scopes.push_back(Scope{&info, {}});
+        for (const auto& parameter : literal->parameters) {
+            this->declare(*parameter);
+        }
+        this->block(literal->body.get());
+        m_scopes.pop_back();
+        return &info;
+    }
+
+    // A late read finds, at run time, whichever binding of its name some
+    // enclosing function has made by then, so it counts as a capture of all
+    // of them. This keeps whatever an escaping closure reaches through it
+    // boxed, and makes a closure it reads escape along with the reader.
+    void captureLate() {
+        for (const auto& [identifier, reader, callee] : m_lateUses) {
+            for (auto function = reader->parent; function; function = function->parent) {
+                for (auto binding : function->locals) {
+                    if (binding->symbol != identifier->symbol) {
+                        continue;
+                    }
+                    ++binding->reads;
+                    if (callee) {
+                        ++binding->calls;
+                    }
+                    binding->captured = true;
+                    m_captures.push_back({binding, reader});
+                }
+            }
+        }
+    }
+
+    // A closure bound by let escapes as soon as its name is used for anything
+    // but a direct call in the same function or in its own body.
+    void markLetBoundEscapes() {
+        std::unordered_set<const Binding*> capturedElsewhere;
+        for (const auto& [binding, reader] : m_captures) {
+            if (binding->declarations != 1 || !binding->function || m_result.Function(binding->function) != reader) {
+                capturedElsewhere.insert(binding);
+            }
+        }
+        for (const auto& [function, binding] : m_letBound) {
+            if (!binding->owner || capturedElsewhere.contains(binding) || binding->reads > binding->calls) {
+                function->escapes = true;
+            }
+        }
+    }
+
+    void markBoxed() {
+        for (const auto& [binding, reader] : m_captures) {
+            if (!binding->owner) {
+                continue;
+            }
+            for (auto function = reader; function != binding->owner; function = function->parent) {
+                if (function->escapes) {
+                    binding->storage = Storage::Boxed;
+                    break;
+                }
+            }
+        }
+    }
+
+    void assignSlots() {
+        for (auto& function : m_result.functions) {
+            for (auto binding : function.locals) {
+                binding->slot = binding->storage == Storage::Boxed ? function.boxedSlots++ : function.frameSlots++;
+            }
+        }
+    }
+
+    resolver::Resolution& m_result;
+    resolver::Session* m_session;
+    std::vector<Scope> m_scopes;
+    std::vector<Capture> m_captures;
+    std::vector<LateUse> m_lateUses;
+    std::vector<std::pair<FunctionInfo*, Binding*>> m_letBound;
+};
+
+} // namespace
+
+resolver::Resolution resolver::Resolve(const ast::Program& program) {
+    Resolution result;
+    Resolver{result, nullptr}.Run(program);
+    return result;
+}
+
+resolver::Resolution resolver::Resolve(const ast::Program& delta, Session& session) {
+    Resolution result;
+    Resolver{result, &session}.Run(delta);
+    return result;
+}
+
+void resolver::Session::Rollback() {
+    for (const auto& [binding, before] : this->undoBindings) {
+        *binding = before;
+    }
+    for (const auto& [binding, before] : this->undoFunctions) {
+        if (before) {
+            this->functions[binding] = before;
+        } else {
+            this->functions.erase(binding);
+        }
+    }
+    while (this->globals.size() > this->undoGlobals) {
+        this->names.erase(this->globals.back().symbol);
+        this->globals.pop_back();
+    }
+    this->undoBindings.clear();
+    this->undoFunctions.clear();
+}
@@ -0,0 +1,133 @@
+#ifndef resolver_resolver_h
+#define resolver_resolver_h
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <ast/ast.h>
+#include <symbols/symbols.h>
+
+namespace resolver
+{
+
+// Where a binding has to live once the program runs.
+enum class Storage {
+    Global, // top-level let, lives as long as the program
+    Frame,  // no escaping closure can see it: a stack or register slot of the call
+    Boxed,  // captured by a closure that may outlive the call: a heap cell
+};
+
+struct FunctionInfo;
+
+struct Binding {
+    std::string_view name; // interned, see symbols::Name
+    symbols::Symbol symbol{};
+    FunctionInfo* owner{}; // nullptr for globals
+    Storage storage{Storage::Frame};
+    uint32_t slot{}; // index among the globals, the owner's frame slots or its boxes
+    uint32_t declarations{}; // parameters and let statements that bind the name
+    uint32_t reads{}; // identifiers resolved to this binding
+    uint32_t calls{}; // reads in callee position of a CallExpression
+    bool captured{}; // read from inside a nested FunctionLteral
+    const ast::FunctionLteral* function{}; // bound to a function literal by let
+};
+
+struct FunctionInfo {
+    bool LeaksLocals() const {
+        return this->boxedSlots != 0;
+    }
+
+    const ast::FunctionLteral* literal{};
+    FunctionInfo* parent{}; // nullptr for functions written at top level
+    bool escapes{}; // the closure may outlive the call that created it
+    std::vector<Binding*> locals; // parameters first, then lets in source order
+    uint32_t frameSlots{};
+    uint32_t boxedSlots{};
+};
+
+// Result of name resolution and escape analysis over one program.
+// Holds pointers into itself, so it can be moved but not copied.
+struct Resolution {
+    Resolution() = default;
+    Resolution(Resolution&&) = default;
+    Resolution& operator=(Resolution&&) = default;
+    Resolution(const Resolution&) = delete;
+    Resolution& operator=(const Resolution&) = delete;
+
+    const FunctionInfo* Function(const ast::FunctionLteral* literal) const {
+        const auto it = this->byLiteral.find(literal);
+        return it == this->byLiteral.end() ? nullptr : it->second;
+    }
+
+    const Binding* Use(const ast::Identifier* identifier) const {
+        const auto it = this->uses.find(identifier);
+        return it == this->uses.end() ? nullptr : it->second;
+    }
+
+    const Binding* Declaration(const ast::LetStatement* let) const {
+        const auto it = this->declarations.find(let);
+        return it == this->declarations.end() ? nullptr : it->second;
+    }
+
+    std::deque<FunctionInfo> functions; // in source order
+    std::deque<Binding> bindings;
+    std::vector<Binding*> globals;
+    std::unordered_map<const ast::FunctionLteral*, FunctionInfo*> byLiteral;
+    std::unordered_map<const ast::Identifier*, Binding*> uses; // free identifiers are absent
+    std::unordered_map<const ast::LetStatement*, Binding*> declarations;
+    // Identifiers read outside any function before any binding of their name,
+    // which fail as soon as they run.
+    std::vector<const ast::Identifier*> unbound;
+    // Identifiers read inside a function body before any binding of their name
+    // is in scope. They are left free: at run time they find whichever
+    // enclosing binding of the name exists by then, so a let of the same name
+    // later in an enclosing scope may be read through them. Each one counts
+    // as a captured read of every local binding of its name in the enclosing
+    // functions.
+    std::vector<const ast::Identifier*> late;
+};
+
+// The global scope of a program that arrives in pieces, such as REPL input,
+// kept between calls to Resolve so that no piece has to be resolved again.
+struct Session {
+    // Undoes what the last Resolve added to or changed in the session, for a
+    // piece that is not going to run.
+    void Rollback();
+
+    std::deque<Binding> globals; // in slot order
+    std::unordered_map<symbols::Symbol, Binding*> names;
+    // The let statements that last bound each global to a function literal,
+    // kept alive for Binding::function.
+    std::unordered_map<const Binding*, std::shared_ptr<ast::Statement>> functions;
+
+    // The undo log of the last Resolve: how many globals there were, and the
+    // earlier state of every global and function entry it changed.
+    std::size_t undoGlobals{};
+    std::unordered_map<Binding*, Binding> undoBindings;
+    std::unordered_map<const Binding*, std::shared_ptr<ast::Statement>> undoFunctions;
+};
+
+// Resolves every identifier to its binding and decides, per function, which
+// parameters and lets can be reached by a nested closure that escapes the call.
+// Only those are Boxed; everything else gets a Frame slot.
+//
+// Like the environments of the book's evaluator, a function body is a single
+// scope (blocks do not open one) and a repeated let rebinds the same name.
+// A use sees the bindings declared before it in source order, except that a
+// let bound to a function literal is visible inside that literal, so direct
+// recursion resolves.
+Resolution Resolve(const ast::Program& program);
+
+// Resolves `delta` as if it followed every piece resolved before with
+// `session`: reads of their globals resolve to the session's bindings, which
+// keep their slots, and the top-level lets of `delta` are added to it in
+// place. The result's `globals` lists every global of the session.
+Resolution Resolve(const ast::Program& delta, Session& session);
+
+} // namespace resolver
+
+#endif // resolver_resolver_h
@@ -0,0 +1,387 @@
+#include "script.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <ast/ast.h>
+#include <emitter/emitter.h>
+#include <lexer/lexer.h>
+#include <optimizer/optimizer.h>
+#include <parser/parser.h>
+#include <resolver/resolver.h>
+#include <stats/stats.h>
+#include <symbols/symbols.h>
+
+namespace
+{
+
+// Layout of monkey_value in the generated runtime.
+struct HostValue {
+    int type;
+    int64_t integer;
+};
+
+// Layout of monkey_limits.
+struct HostLimits {
+    uint64_t fuel;
+    uint64_t timeoutNs;
+    uint64_t memory;
+};
+
+// Layout of monkey_globals.
+struct HostGlobals {
+    void** cells;
+    const char* const* names;
+    std::size_t count;
+};
+
+// Layout of monkey_usage.
+struct HostUsage {
+    uint64_t allocated;
+    uint64_t peak;
+    uint64_t live;
+};
+
+HostValue toHost(const script::Value& value) {
+    if (const auto integer = std::get_if<int64_t>(&value)) {
+        return {1, *integer};
+    }
+    if (const auto boolean = std::get_if<bool>(&value)) {
+        return {2, *boolean};
+    }
+    return {0, 0};
+}
+
+script::Value fromHost(const HostValue& value) {
+    switch (value.type) {
+    case 1:
+        return value.integer;
+    case 2:
+        return value.integer != 0;
+    case 3:
+        return script::Function{};
+    default:
+        return script::Null{};
+    }
+}
+
+// Whether the lexer reads `name` as a single identifier. The emitter pastes
+// input names into C++ identifiers and string literals as they are.
+bool isIdentifier(std::string_view name) {
+    return !name.empty() && std::ranges::all_of(name, [](char ch) { return lexer::isLetter(ch); }) &&
+           token::LookupIdent(name) == token::IDENT;
+}
+
+// Builds `code` into a shared library in a fresh directory under the system
+// temporary directory and loads it; the files are removed once it is loaded.
+// The compiler is run directly rather than through a shell, so neither it nor
+// the paths are ever parsed as a command line.
+void* build(const std::string& code, const script::Options& options, std::vector<std::string>& errors) {
+    std::error_code error;
+    auto pattern = (std::filesystem::temp_directory_path(error) / "monkeyXXXXXX").string();
+    if (error || !::mkdtemp(pattern.data())) {
+        errors.emplace_back("cannot create a directory for the compiled script: " +
+                            (error ? error.message() : std::string{std::strerror(errno)}));
+        return nullptr;
+    }
+    const std::filesystem::path directory = pattern;
+    const auto source = directory / "script.cpp";
+    const auto library = directory / "script.so";
+    const auto log = directory / "build.log";
+
+    void* handle{};
+    std::vector<std::string> arguments{options.compiler, "-std=c++20"};
+    std::istringstream flags{options.flags};
+    for (std::string flag; flags >> flag;) {
+        arguments.push_back(std::move(flag));
+    }
+    arguments.insert(arguments.end(), {"-shared", "-fPIC", "-o", library.string(), source.string()});
+    std::vector<char*> argv;
+    for (auto& argument : arguments) {
+        argv.push_back(argument.data());
+    }
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    ::posix_spawn_file_actions_init(&actions);
+    ::posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    ::posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+    pid_t pid{};
+    int status{};
+    if (!(std::ofstream{source} << code)) {
+        errors.emplace_back("cannot write the compiled script to " + directory.string());
+    } else if (const auto spawned = ::posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+               spawned != 0) {
+        errors.emplace_back("cannot run the compiler " + options.compiler + ": " + std::strerror(spawned));
+    } else if (::waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::string command;
+        for (const auto& argument : arguments) {
+            command += (command.empty() ? "" : " ") + argument;
+        }
+        std::stringstream output;
+        output << std::ifstream{log}.rdbuf();
+        errors.emplace_back("cannot build the script: " + command + '\n' + output.str());
+    } else if (handle = ::dlopen(library.c_str(), RTLD_NOW | RTLD_LOCAL); !handle) {
+        errors.emplace_back(std::string{"cannot load the script: "} + ::dlerror());
+    }
+    ::posix_spawn_file_actions_destroy(&actions);
+    std::filesystem::remove_all(directory, error);
+    return handle;
+}
+
+// Parses what `lexer` reads into a program that can be translated.
+std::optional<ast::Program> parse(lexer::Lexer lexer, std::vector<std::string>& errors) {
+    ast::Program program;
+    try {
+        const stats::Scope scope{"parse"};
+        auto p = Parser(std::move(lexer));
+        program = p.ParseProgram();
+        if (!p.Errors().empty()) {
+            errors.insert(errors.end(), p.Errors().begin(), p.Errors().end());
+            return std::nullopt;
+        }
+    } catch (const std::length_error& e) {
+        // The symbol table is full; see symbols::Capacity.
+        errors.emplace_back(e.what());
+        return std::nullopt;
+    }
+    if (ast::Depth(program) > emitter::MaxTranslatedDepth) {
+        errors.emplace_back("expressions nested deeper than " + std::to_string(emitter::MaxTranslatedDepth) +
+                            " cannot be translated");
+        return std::nullopt;
+    }
+    return program;
+}
+
+// Translates and builds a whole script; the library defines monkey_execute.
+void* compile(lexer::Lexer lexer, const std::vector<std::string>& inputs, std::vector<std::string>& errors,
+              const script::Options& options) {
+    for (const auto& name : inputs) {
+        if (!isIdentifier(name)) {
+            errors.emplace_back("input name is not an identifier: " + name);
+            return nullptr;
+        }
+        try {
+            symbols::Intern(name);
+        } catch (const std::length_error& e) {
+            errors.emplace_back(e.what());
+            return nullptr;
+        }
+    }
+
+    auto program = parse(std::move(lexer), errors);
+    if (!program) {
+        return nullptr;
+    }
+    optimizer::Optimize(*program);
+
+    emitter::Options emitted;
+    emitted.profile = options.profile;
+    emitted.inputs = inputs;
+    std::string code;
+    {
+        const stats::Scope scope{"emit"};
+        code = emitter::EmitCpp(*program, emitted);
+    }
+
+    void* library{};
+    {
+        const stats::Scope scope{"build"};
+        library = build(code, options, errors);
+    }
+    if (library && !::dlsym(library, "monkey_execute")) {
+        errors.emplace_back("the compiled script has no monkey_execute");
+        ::dlclose(library);
+        return nullptr;
+    }
+    return library;
+}
+
+} // namespace
+
+std::shared_ptr<const script::CompiledScript> script::CompiledScript::Compile(std::string_view source,
+                                                                              std::vector<std::string> inputs,
+                                                                              std::vector<std::string>& errors,
+                                                                              const Options& options) {
+    const auto library = compile(lexer::Lexer(std::string{source}), inputs, errors, options);
+    if (!library) {
+        return nullptr;
+    }
+    const auto entry = reinterpret_cast<Entry>(::dlsym(library, "monkey_execute"));
+    return std::shared_ptr<const CompiledScript>(new CompiledScript{std::move(inputs), library, entry});
+}
+
+std::shared_ptr<const script::CompiledScript> script::CompiledScript::Compile(std::istream& source,
+                                                                              std::vector<std::string> inputs,
+                                                                              std::vector<std::string>& errors,
+                                                                              const Options& options) {
+    const auto library = compile(lexer::FromStream(source), inputs, errors, options);
+    if (!library) {
+        return nullptr;
+    }
+    const auto entry = reinterpret_cast<Entry>(::dlsym(library, "monkey_execute"));
+    return std::shared_ptr<const CompiledScript>(new CompiledScript{std::move(inputs), library, entry});
+}
+
+script::CompiledScript::CompiledScript(std::vector<std::string> inputs, void* library, Entry entry) :
+    m_inputs{std::move(inputs)},
+    m_library{library},
+    m_entry{entry}
+{}
+
+script::CompiledScript::~CompiledScript() {
+    ::dlclose(this->m_library);
+}
+
+const std::vector<std::string>& script::CompiledScript::Inputs() const {
+    return this->m_inputs;
+}
+
+script::Result script::CompiledScript::Execute(std::span<const Value> inputs, const Limits& limits) const {
+    std::vector<HostValue> values(this->m_inputs.size(), HostValue{0, 0});
+    for (std::size_t i = 0; i < std::min(inputs.size(), values.size()); ++i) {
+        values[i] = toHost(inputs[i]);
+    }
+
+    const HostLimits bounds{limits.fuel, static_cast<uint64_t>(std::max<int64_t>(limits.timeout.count(), 0)),
+                            limits.memory};
+    HostValue result{};
+    HostUsage usage{};
+    char error[256]{};
+    const auto failed = this->m_entry(values.data(), &bounds, &result, &usage, error, sizeof(error)) != 0;
+    const Usage used{usage.allocated, usage.peak, usage.live};
+    if (failed) {
+        return {Null{}, error, used};
+    }
+    return {fromHost(result), {}, used};
+}
+
+struct script::Session::State {
+    using Piece = int (*)(HostGlobals* globals, void* result, char* error, std::size_t size);
+    using Release = void (*)(HostGlobals* globals);
+    using Report = void (*)(const char* stack, uint64_t count, void* context);
+    using ProfileStart = void (*)();
+    using ProfileStop = void (*)(Report report, void* context);
+
+    resolver::Session resolver;
+    std::vector<void*> cells; // a cell per global slot, made by the piece that first runs with it
+    std::vector<std::string> names;
+    std::vector<const char*> cNames;
+    HostGlobals globals{}; // what pieces see of the above; its address outlives them
+    std::vector<void*> libraries; // closures made by every piece may still be called
+};
+
+script::Session::Session(Options options) :
+    m_options{std::move(options)},
+    m_state{std::make_unique<State>()}
+{}
+
+script::Session::~Session() {
+    if (this->m_state->libraries.empty()) {
+        return;
+    }
+    const auto release =
+        reinterpret_cast<State::Release>(::dlsym(this->m_state->libraries.back(), "monkey_release"));
+    release(&this->m_state->globals);
+    for (auto library = this->m_state->libraries.rbegin(); library != this->m_state->libraries.rend(); ++library) {
+        ::dlclose(*library);
+    }
+}
+
+std::optional<script::Result> script::Session::Run(std::string_view source, std::vector<std::string>& errors) {
+    return this->run(source, errors, nullptr);
+}
+
+std::optional<script::Result> script::Session::Profile(std::string_view source, std::vector<std::string>& errors,
+                                                       std::string& folded) {
+    return this->run(source, errors, &folded);
+}
+
+std::optional<script::Result> script::Session::run(std::string_view source, std::vector<std::string>& errors,
+                                                   std::string* folded) {
+    auto program = parse(lexer::Lexer(std::string{source}), errors);
+    if (!program) {
+        return std::nullopt;
+    }
+
+    auto& state = *this->m_state;
+    resolver::Resolve(*program, state.resolver);
+    emitter::Options emitted;
+    emitted.piece = true;
+    emitted.profile = this->m_options.profile || folded;
+    for (const auto& binding : state.resolver.globals) {
+        emitted.globals.emplace_back(binding.name);
+    }
+    std::string code;
+    {
+        const stats::Scope scope{"emit"};
+        code = emitter::EmitCpp(*program, emitted);
+    }
+
+    void* library{};
+    {
+        const stats::Scope scope{"build"};
+        library = build(code, this->m_options, errors);
+    }
+    const auto piece = library ? reinterpret_cast<State::Piece>(::dlsym(library, "monkey_piece")) : nullptr;
+    if (!piece) {
+        if (library) {
+            errors.emplace_back("the compiled piece has no monkey_piece");
+            ::dlclose(library);
+        }
+        state.resolver.Rollback();
+        return std::nullopt;
+    }
+    state.libraries.push_back(library);
+    state.cells.resize(emitted.globals.size());
+    for (auto i = state.names.size(); i < emitted.globals.size(); ++i) {
+        state.names.push_back(emitted.globals[i]);
+    }
+    state.cNames.clear();
+    for (const auto& name : state.names) {
+        state.cNames.push_back(name.c_str());
+    }
+    state.globals = {state.cells.data(), state.cNames.data(), state.cells.size()};
+
+    if (folded) {
+        reinterpret_cast<State::ProfileStart>(::dlsym(library, "monkey_profile_start"))();
+    }
+    HostValue result{};
+    char error[256]{};
+    const auto failed = piece(&state.globals, &result, error, sizeof(error)) != 0;
+    if (folded) {
+        const auto report = [](const char* stack, uint64_t count, void* context) {
+            auto& out = *static_cast<std::string*>(context);
+            out += stack;
+            out += ' ' + std::to_string(count) + '\n';
+        };
+        reinterpret_cast<State::ProfileStop>(::dlsym(library, "monkey_profile_stop"))(report, folded);
+    }
+    if (failed) {
+        return Result{Null{}, error, {}};
+    }
+    return Result{fromHost(result), {}, {}};
+}
+
+std::string script::Inspect(const Value& value) {
+    if (const auto integer = std::get_if<int64_t>(&value)) {
+        return std::to_string(*integer);
+    }
+    if (const auto boolean = std::get_if<bool>(&value)) {
+        return *boolean ? "true" : "false";
+    }
+    return std::holds_alternative<Function>(value) ? "fn" : "null";
+}
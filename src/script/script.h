@@ -0,0 +1,146 @@
+#ifndef script_script_h
+#define script_script_h
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace script
+{
+
+struct Null {
+    bool operator==(const Null&) const = default;
+};
+
+// A closure, which cannot leave the script.
+struct Function {
+    bool operator==(const Function&) const = default;
+};
+
+using Value = std::variant<Null, int64_t, bool, Function>;
+
+// The value as the REPL prints it.
+std::string Inspect(const Value& value);
+
+// Bytes of cells and closures, the only values that outlive the call that
+// makes them, during one execution.
+struct Usage {
+    uint64_t allocated{};
+    uint64_t peak{}; // the most live at once
+    // Still held when the execution returned, after the cells kept alive
+    // only by reference cycles between closures were emptied.
+    uint64_t live{};
+};
+
+struct Result {
+    Value value;
+    std::string error; // a runtime error such as "integer overflow", or empty
+    Usage usage;
+};
+
+// Bounds one execution, so that a runaway script fails with "fuel exhausted",
+// "timeout" or "out of memory" instead of holding its thread or exhausting the
+// process. Zero means unlimited.
+struct Limits {
+    uint64_t fuel{}; // function calls
+    std::chrono::nanoseconds timeout{};
+    uint64_t memory{}; // bytes, as counted in Usage
+};
+
+struct Options {
+    // Run, without a shell, as `<compiler> -std=c++20 <flags> -shared -fPIC`
+    // on the translated script; `compiler` is looked up on PATH and `flags`
+    // are split at whitespace.
+    std::string compiler = "c++";
+    std::string flags = "-O2";
+    // Keeps calls on a shadow stack for MONKEY_PROFILE or Session::Profile to
+    // sample; see emitter::Options.
+    bool profile{};
+};
+
+// A script translated by emit-cpp and built into a shared library once, to be
+// executed any number of times with different inputs.
+class CompiledScript
+{
+public:
+    // Parses, optimizes and builds `source`. `inputs` names the globals the
+    // host sets before every execution; the script sees them from its first
+    // statement on and may rebind them, so each must be a Monkey identifier
+    // (letters and underscores, not a keyword). Returns nullptr and fills
+    // `errors` with the rejected input, parse errors, why the compiler could
+    // not be run or its output on failure.
+    static std::shared_ptr<const CompiledScript> Compile(std::string_view source, std::vector<std::string> inputs,
+                                                         std::vector<std::string>& errors, const Options& options = {});
+
+    // As above, reading the source from `source` a chunk at a time.
+    static std::shared_ptr<const CompiledScript> Compile(std::istream& source, std::vector<std::string> inputs,
+                                                         std::vector<std::string>& errors, const Options& options = {});
+
+    ~CompiledScript();
+
+    CompiledScript(const CompiledScript&) = delete;
+    CompiledScript& operator=(const CompiledScript&) = delete;
+
+    // The names given to Compile, in the order Execute takes their values.
+    const std::vector<std::string>& Inputs() const;
+
+    // Runs the script once with `inputs` in the order of Inputs(); missing
+    // trailing inputs are null. Every execution has globals of its own, so
+    // one script may run on several threads at once.
+    Result Execute(std::span<const Value> inputs = {}, const Limits& limits = {}) const;
+
+private:
+    using Entry = int (*)(const void* inputs, const void* limits, void* result, void* usage, char* error,
+                          std::size_t size);
+
+    CompiledScript(std::vector<std::string> inputs, void* library, Entry entry);
+
+    std::vector<std::string> m_inputs;
+    void* m_library;
+    Entry m_entry;
+};
+
+// A program that arrives in pieces, such as REPL input. Each piece is
+// translated and built on its own against the globals that earlier pieces
+// declared, and run at once; nothing that came before is parsed or built
+// again. A session is used from one thread at a time.
+class Session
+{
+public:
+    explicit Session(Options options = {});
+    ~Session();
+
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+
+    // Builds and runs `source` as the next piece. Returns nullopt and fills
+    // `errors` when it cannot be built, in which case it declares nothing; a
+    // piece that fails at run time keeps what it bound before the error.
+    std::optional<Result> Run(std::string_view source, std::vector<std::string>& errors);
+
+    // As Run, sampling calls while the piece runs and appending them to
+    // `folded` as folded stacks, "program;fib:1:11 42" per line. Functions
+    // that earlier pieces declared appear in the stacks only when the session
+    // was made with `profile`.
+    std::optional<Result> Profile(std::string_view source, std::vector<std::string>& errors, std::string& folded);
+
+private:
+    struct State;
+
+    std::optional<Result> run(std::string_view source, std::vector<std::string>& errors, std::string* folded);
+
+    Options m_options;
+    std::unique_ptr<State> m_state;
+};
+
+} // namespace script
+
+#endif // script_script_h
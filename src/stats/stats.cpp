@@ -0,0 +1,110 @@
+#include "stats.h"
+
+#include <atomic>
+
+#include <fmt/format.h>
+
+#include <trace/trace.h>
+
+namespace
+{
+
+constinit std::atomic<bool> counting{false};
+constinit std::atomic<uint64_t> allocations{0};
+constinit std::atomic<uint64_t> allocatedBytes{0};
+
+// Scopes opened on other threads, such as compiles run by an embedder, do not
+// touch the report of the thread that called Start.
+thread_local stats::Report* active{};
+
+} // namespace
+
+void stats::CountAllocation(std::size_t size) {
+    if (counting.load(std::memory_order_relaxed)) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+}
+
+stats::Allocations stats::Allocated() {
+    return {allocations.load(std::memory_order_relaxed), allocatedBytes.load(std::memory_order_relaxed)};
+}
+
+void stats::Start(Report& report) {
+    active = &report;
+    counting.store(true, std::memory_order_relaxed);
+}
+
+void stats::Stop() {
+    counting.store(false, std::memory_order_relaxed);
+    active = nullptr;
+}
+
+stats::Scope::Scope(std::string_view name) :
+    m_report{active},
+    m_tracing{trace::Enabled()},
+    m_name{name}
+{
+    if (!this->m_report && !this->m_tracing) {
+        return;
+    }
+    if (this->m_report) {
+        // The phase is added before measuring, so its own allocation is not
+        // charged to it and nested scopes come after their parent.
+        this->m_index = this->m_report->phases.size();
+        this->m_report->phases.push_back(Phase{std::string{name}, 0.0, {}});
+        this->m_allocated = Allocated();
+    }
+    this->m_start = std::chrono::steady_clock::now();
+}
+
+stats::Scope::~Scope() {
+    if (!this->m_report && !this->m_tracing) {
+        return;
+    }
+    const auto end = std::chrono::steady_clock::now();
+    if (this->m_tracing) {
+        trace::Record(this->m_name, this->m_start, end);
+    }
+    if (!this->m_report) {
+        return;
+    }
+    const auto elapsed = end - this->m_start;
+    const auto allocated = Allocated();
+    auto& phase = this->m_report->phases[this->m_index];
+    phase.milliseconds = std::chrono::duration<double, std::milli>(elapsed).count();
+    phase.allocations = {allocated.count - this->m_allocated.count, allocated.bytes - this->m_allocated.bytes};
+}
+
+std::string stats::Table(const Report& report) {
+    auto out = fmt::format("{:<12}{:>12}{:>14}{:>14}\n", "phase", "ms", "allocations", "bytes");
+    for (const auto& phase : report.phases) {
+        out += fmt::format("{:<12}{:>12.3f}{:>14}{:>14}\n", phase.name, phase.milliseconds, phase.allocations.count,
+                           phase.allocations.bytes);
+    }
+    out += fmt::format("\ntokens{:>20}\n", report.tokens);
+    if (!report.nodes.empty()) {
+        out += "\nnodes\n";
+    }
+    for (const auto& [kind, count] : report.nodes) {
+        out += fmt::format("  {:<20}{:>10}\n", kind, count);
+    }
+    return out;
+}
+
+std::string stats::Json(const Report& report) {
+    std::string out = "{\"phases\": [";
+    for (std::size_t i = 0; i < report.phases.size(); ++i) {
+        const auto& phase = report.phases[i];
+        out += fmt::format("{}{{\"name\": \"{}\", \"ms\": {:.3f}, \"allocations\": {}, \"bytes\": {}}}", i > 0 ? ", " : "",
+                           phase.name, phase.milliseconds, phase.allocations.count, phase.allocations.bytes);
+    }
+    out += fmt::format("], \"tokens\": {}, \"nodes\": {{", report.tokens);
+    auto first = true;
+    for (const auto& [kind, count] : report.nodes) {
+        out += fmt::format("{}\"{}\": {}", first ? "" : ", ", kind, count);
+        first = false;
+    }
+    out += "}}\n";
+    return out;
+}
@@ -0,0 +1,77 @@
+#ifndef stats_stats_h
+#define stats_stats_h
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace stats
+{
+
+struct Allocations {
+    uint64_t count{};
+    uint64_t bytes{};
+};
+
+// Calls to the global operator new made while a report was active, over the
+// whole process. Only programs that link the counting operator new of
+// src/allocations.cpp, monkey.exe and the tests, count anything; libmonkey
+// leaves an embedder's allocator alone.
+Allocations Allocated();
+
+// Counts one allocation of `size` bytes if a report is active; called by the
+// counting operator new.
+void CountAllocation(std::size_t size);
+
+struct Phase {
+    std::string name;
+    double milliseconds{};
+    Allocations allocations;
+};
+
+// What the front end and later phases cost on one script.
+struct Report {
+    std::vector<Phase> phases; // in the order they started
+    std::size_t tokens{};
+    std::map<std::string_view, std::size_t> nodes; // see ast::Census
+};
+
+// Makes `report` collect every Scope opened on the calling thread until
+// Stop(). Allocations are counted process-wide.
+void Start(Report& report);
+void Stop();
+
+// Records wall time and allocations from construction to destruction as a
+// phase of the active report, and the same interval as a trace::Record span
+// while tracing; does nothing otherwise. `name` must outlive the trace.
+class Scope
+{
+public:
+    explicit Scope(std::string_view name);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    Report* m_report;
+    bool m_tracing;
+    std::string_view m_name;
+    std::size_t m_index{};
+    Allocations m_allocated;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+// One row per phase followed by the token and node counts.
+std::string Table(const Report& report);
+
+// {"phases": [{"name", "ms", "allocations", "bytes"}...], "tokens", "nodes": {kind: count}}
+std::string Json(const Report& report);
+
+} // namespace stats
+
+#endif // stats_stats_h
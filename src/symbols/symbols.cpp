@@ -0,0 +1,116 @@
+#include "symbols.h"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace
+{
+
+// Names are found by symbol in blocks of doubling size, block b holding
+// symbols 2^b - 1 to 2^(b+1) - 2, so that a block never moves once
+// published and Name() needs no lock.
+constexpr std::size_t Blocks = 32;
+
+// What a name costs besides its text: its string in the deque, its entry in
+// the map and its slot in a block.
+constexpr std::size_t PerName = sizeof(std::string) + 4 * sizeof(void*) + 2 * sizeof(std::string_view);
+
+struct Table {
+    ~Table() {
+        for (auto& block : blocks) {
+            delete[] block.load();
+        }
+    }
+
+    std::shared_mutex mutex; // shared to look up ids, exclusive to add a name
+    std::deque<std::string> names; // a deque never moves its elements
+    std::unordered_map<std::string_view, symbols::Symbol> ids;
+    std::array<std::atomic<std::string_view*>, Blocks> blocks{};
+    std::atomic<uint32_t> count{0};
+    std::atomic<std::size_t> bytes{0}; // written under the exclusive lock
+    std::atomic<std::size_t> capacity{symbols::DefaultCapacity};
+};
+
+Table& table() {
+    static Table instance;
+    return instance;
+}
+
+struct Slot {
+    std::size_t block;
+    std::size_t index;
+};
+
+Slot slot(symbols::Symbol symbol) {
+    const auto position = static_cast<uint64_t>(symbol) + 1;
+    const auto block = static_cast<std::size_t>(std::bit_width(position) - 1);
+    return {block, static_cast<std::size_t>(position - (uint64_t{1} << block))};
+}
+
+} // namespace
+
+symbols::Symbol symbols::Intern(std::string_view name) {
+    auto& t = table();
+    {
+        // Most identifiers are already interned; lexers on several threads
+        // look them up together.
+        const std::shared_lock lock{t.mutex};
+        if (const auto it = t.ids.find(name); it != t.ids.end()) {
+            return it->second;
+        }
+    }
+    const std::unique_lock lock{t.mutex};
+    if (const auto it = t.ids.find(name); it != t.ids.end()) {
+        return it->second;
+    }
+    const auto bytes = t.bytes.load(std::memory_order_relaxed) + name.size() + PerName;
+    if (bytes > t.capacity.load(std::memory_order_relaxed)) {
+        throw std::length_error{"too many distinct names"};
+    }
+    const auto symbol = static_cast<Symbol>(t.names.size());
+    const auto& stored = t.names.emplace_back(name);
+    t.ids.emplace(stored, symbol);
+
+    const auto [block, index] = slot(symbol);
+    auto names = t.blocks[block].load(std::memory_order_relaxed);
+    if (!names) {
+        names = new std::string_view[std::size_t{1} << block];
+        t.blocks[block].store(names, std::memory_order_release);
+    }
+    names[index] = stored;
+    t.count.store(symbol + 1, std::memory_order_release);
+    t.bytes.store(bytes, std::memory_order_relaxed);
+    return symbol;
+}
+
+std::string_view symbols::Name(Symbol symbol) {
+    auto& t = table();
+    if (symbol >= t.count.load(std::memory_order_acquire)) {
+        throw std::out_of_range{"unknown symbol"};
+    }
+    const auto [block, index] = slot(symbol);
+    return t.blocks[block].load(std::memory_order_acquire)[index];
+}
+
+std::size_t symbols::Count() {
+    return table().count.load(std::memory_order_acquire);
+}
+
+void symbols::SetCapacity(std::size_t bytes) {
+    table().capacity.store(bytes, std::memory_order_relaxed);
+}
+
+std::size_t symbols::Capacity() {
+    return table().capacity.load(std::memory_order_relaxed);
+}
+
+std::size_t symbols::Bytes() {
+    return table().bytes.load(std::memory_order_relaxed);
+}
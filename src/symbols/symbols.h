@@ -0,0 +1,46 @@
+#ifndef symbols_symbols_h
+#define symbols_symbols_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace symbols
+{
+
+// Identifies an interned name. Equal names always get the same symbol, so
+// comparing two names is comparing two integers.
+using Symbol = uint32_t;
+
+// Returns the symbol of `name`, interning it on first sight. The table is
+// shared by every lexer in the process and safe to use from several threads;
+// names already interned are found under a shared lock, so only new names
+// make lexers wait for each other.
+Symbol Intern(std::string_view name);
+
+// The text of an interned symbol. It stays valid for the rest of the process.
+// Never takes a lock.
+std::string_view Name(Symbol symbol);
+
+// Number of distinct names interned so far.
+std::size_t Count();
+
+// Names are never forgotten, since symbols and the text Name returns must stay
+// valid for the rest of the process; the table is bounded instead. Once the
+// names interned take Capacity() bytes, counting their text and a fixed cost
+// per name, Intern throws std::length_error for a new name, while names
+// already interned are still found. The capacity is DefaultCapacity until a
+// host sets another, say to bound a service that compiles scripts from many
+// sources.
+constexpr std::size_t DefaultCapacity = std::size_t{64} << 20;
+
+void SetCapacity(std::size_t bytes);
+
+std::size_t Capacity();
+
+// Bytes the names interned so far take, as counted against the capacity.
+std::size_t Bytes();
+
+} // namespace symbols
+
+#endif // symbols_symbols_h
@@ -1,55 +1,73 @@
 #ifndef token_token_h
 #define token_token_h
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <utility>
 
 namespace token
 {
 
+// Tokens are handed from the lexer to the parser and never shared, so they
+// are moved rather than copied along with their literal.
 struct Token {
-    std::string type;
+    Token() = default;
+    Token(std::string_view type, std::string literal) :
+        type{type},
+        literal{std::move(literal)}
+    {}
+
+    Token(Token&&) = default;
+    Token& operator=(Token&&) = default;
+    Token(const Token&) = delete;
+    Token& operator=(const Token&) = delete;
+
+    std::string_view type; // one of the constants below
     std::string literal;
+    int64_t value{}; // an INT's decoded value, an IDENT's symbols::Symbol
+    uint32_t offset{}; // of the first byte in the input, see lexer::Lexer::Locate
 };
 
-inline std::string ILLEGAL = "ILLEGAL";
+inline constexpr std::string_view ILLEGAL = "ILLEGAL";
 
-inline std::string eof  = "EOF";
+inline constexpr std::string_view eof  = "EOF";
 
-inline std::string IDENT = "IDENT"; // add, foobar, x, y, ...
-inline std::string INT   = "INT";   // 1343456
+inline constexpr std::string_view IDENT = "IDENT"; // add, foobar, x, y, ...
+inline constexpr std::string_view INT   = "INT";   // 1343456
 
 	// Operators
-inline std::string ASSIGN   = "=";
-inline std::string PLUS     = "+";
-inline std::string MINUS    = "-";
-inline std::string BANG     = "!";
-inline std::string ASTERISK = "*";
-inline std::string SLASH    = "/";
+inline constexpr std::string_view ASSIGN   = "=";
+inline constexpr std::string_view PLUS     = "+";
+inline constexpr std::string_view MINUS    = "-";
+inline constexpr std::string_view BANG     = "!";
+inline constexpr std::string_view ASTERISK = "*";
+inline constexpr std::string_view SLASH    = "/";
 
-inline std::string LT = "<";
-inline std::string GT = ">";
+inline constexpr std::string_view LT = "<";
+inline constexpr std::string_view GT = ">";
 
-inline std::string EQ     = "==";
-inline std::string NOT_EQ = "!=";
+inline constexpr std::string_view EQ     = "==";
+inline constexpr std::string_view NOT_EQ = "!=";
 
 	// Delimiters
-inline std::string COMMA     = ",";
-inline std::string SEMICOLON = ";";
+inline constexpr std::string_view COMMA     = ",";
+inline constexpr std::string_view SEMICOLON = ";";
 
-inline std::string LPAREN = "(";
-inline std::string RPAREN = ")";
-inline std::string LBRACE = "{";
-inline std::string RBRACE = "}";
+inline constexpr std::string_view LPAREN = "(";
+inline constexpr std::string_view RPAREN = ")";
+inline constexpr std::string_view LBRACE = "{";
+inline constexpr std::string_view RBRACE = "}";
 
 	// Keywords
-inline std::string FUNCTION = "FUNCTION";
+inline constexpr std::string_view FUNCTION = "FUNCTION";
 inline constexpr std::string_view LET      = "LET";
-inline std::string TRUE     = "TRUE";
-inline std::string FALSE    = "FALSE";
-inline std::string IF       = "IF";
-inline std::string ELSE     = "ELSE";
-inline std::string RETURN   = "RETURN";
+inline constexpr std::string_view TRUE     = "TRUE";
+inline constexpr std::string_view FALSE    = "FALSE";
+inline constexpr std::string_view IF       = "IF";
+inline constexpr std::string_view ELSE     = "ELSE";
+inline constexpr std::string_view RETURN   = "RETURN";
 
 inline const std::unordered_map<std::string_view, std::string_view> keywords{
     {"fn",     FUNCTION},
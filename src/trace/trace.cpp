@@ -0,0 +1,145 @@
+#include "trace.h"
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <fmt/format.h>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+struct Event {
+    std::string_view name;
+    Clock::time_point start;
+    Clock::time_point end;
+};
+
+// Written only by its own thread; `next` counts every span ever recorded, so
+// the ring holds the last min(next, events.size()) of them.
+struct Ring {
+    std::vector<Event> events;
+    std::atomic<uint64_t> next{0};
+    uint32_t thread{};
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<Ring>> rings;
+    std::string path;
+    std::size_t capacity{};
+    Clock::time_point origin;
+    bool flushAtExit{};
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+constinit std::atomic<bool> enabled{false};
+// Bumped by every Start() so that threads drop rings of an earlier trace.
+constinit std::atomic<uint64_t> generation{0};
+
+Ring& ring() {
+    thread_local std::shared_ptr<Ring> current;
+    thread_local uint64_t currentGeneration{};
+    const auto now = generation.load(std::memory_order_acquire);
+    if (!current || currentGeneration != now) {
+        auto& r = registry();
+        const std::lock_guard lock{r.mutex};
+        current = std::make_shared<Ring>();
+        current->events.resize(r.capacity);
+        current->thread = static_cast<uint32_t>(r.rings.size() + 1);
+        r.rings.push_back(current);
+        currentGeneration = now;
+    }
+    return *current;
+}
+
+void flush() {
+    if (!enabled.load()) {
+        return;
+    }
+    auto path = registry().path;
+    if (path.empty()) {
+        return;
+    }
+    std::ofstream out{path, std::ios::binary};
+    out << trace::Json();
+    if (!out) {
+        std::cerr << "cannot write trace to " << path << '\n';
+    }
+}
+
+} // namespace
+
+void trace::Start(std::string path, std::size_t capacity) {
+    auto& r = registry();
+    {
+        const std::lock_guard lock{r.mutex};
+        r.rings.clear();
+        r.path = std::move(path);
+        r.capacity = std::bit_ceil(std::max<std::size_t>(capacity, 1));
+        r.origin = Clock::now();
+        if (!r.flushAtExit) {
+            std::atexit(flush);
+            r.flushAtExit = true;
+        }
+    }
+    generation.fetch_add(1, std::memory_order_release);
+    // Allocating the ring here keeps it out of the first span.
+    ring();
+    enabled.store(true);
+}
+
+void trace::Stop() {
+    enabled.store(false);
+    auto& r = registry();
+    const std::lock_guard lock{r.mutex};
+    r.rings.clear();
+}
+
+bool trace::Enabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void trace::Record(std::string_view name, std::chrono::steady_clock::time_point start,
+                   std::chrono::steady_clock::time_point end) {
+    if (!Enabled()) {
+        return;
+    }
+    auto& r = ring();
+    const auto next = r.next.load(std::memory_order_relaxed);
+    r.events[next & (r.events.size() - 1)] = Event{name, start, end};
+    r.next.store(next + 1, std::memory_order_release);
+}
+
+std::string trace::Json() {
+    auto& r = registry();
+    const std::lock_guard lock{r.mutex};
+    std::string out = "{\"traceEvents\": [";
+    auto first = true;
+    for (const auto& ring : r.rings) {
+        const auto next = ring->next.load(std::memory_order_acquire);
+        const auto size = ring->events.size();
+        for (auto i = next > size ? next - size : 0; i < next; ++i) {
+            const auto& event = ring->events[i & (size - 1)];
+            const auto start = std::chrono::duration<double, std::micro>(event.start - r.origin).count();
+            const auto duration = std::chrono::duration<double, std::micro>(event.end - event.start).count();
+            out += fmt::format("{}\n{{\"name\": \"{}\", \"ph\": \"X\", \"ts\": {:.3f}, \"dur\": {:.3f}, \"pid\": 1, \"tid\": {}}}",
+                               first ? "" : ",", event.name, start, duration, ring->thread);
+            first = false;
+        }
+    }
+    out += "\n]}\n";
+    return out;
+}
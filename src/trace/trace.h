@@ -0,0 +1,37 @@
+#ifndef trace_trace_h
+#define trace_trace_h
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace trace
+{
+
+// Spans kept per thread before the oldest are overwritten.
+inline constexpr std::size_t DefaultCapacity = 1 << 16;
+
+// Starts recording spans, to be written to `path` as Chrome trace-event JSON
+// (chrome://tracing, ui.perfetto.dev) when the process exits; an empty path
+// only buffers them. Each thread appends to a ring of its own without
+// locking, rounded up to a power of two of at least `capacity` spans.
+void Start(std::string path, std::size_t capacity = DefaultCapacity);
+
+// Stops recording and drops what was buffered.
+void Stop();
+
+bool Enabled();
+
+// Records a finished span on the calling thread. `name` must stay valid until
+// the trace is written.
+void Record(std::string_view name, std::chrono::steady_clock::time_point start,
+            std::chrono::steady_clock::time_point end);
+
+// The buffered spans of every thread as a trace-event document. Threads are
+// expected to be done recording.
+std::string Json();
+
+} // namespace trace
+
+#endif // trace_trace_h
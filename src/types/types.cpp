@@ -0,0 +1,269 @@
+#include "types.h"
+
+#include <optional>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+
+using types::Type;
+
+// nullopt is the bottom of the lattice: no value has been seen yet.
+using Lattice = std::optional<Type>;
+
+Lattice join(Lattice a, Lattice b) {
+    if (!a) {
+        return b;
+    }
+    if (!b) {
+        return a;
+    }
+    return *a == *b ? a : Type::Unknown;
+}
+
+class Inferer
+{
+public:
+    Inferer(const resolver::Resolution& resolution, types::Inference& result) :
+        m_resolution{resolution},
+        m_result{result}
+    {
+        // A read that precedes the let may reach the function at run time
+        // without being counted among its calls.
+        std::unordered_set<symbols::Symbol> late;
+        for (const auto identifier : resolution.late) {
+            late.insert(identifier->symbol);
+        }
+        for (const auto& binding : resolution.bindings) {
+            if (binding.function && binding.declarations == 1 && binding.reads == binding.calls &&
+                !late.contains(binding.symbol)) {
+                m_closed.emplace(binding.function, &binding);
+            }
+        }
+        for (const auto& function : resolution.functions) {
+            if (m_closed.contains(function.literal)) {
+                continue;
+            }
+            for (const auto& parameter : function.literal->parameters) {
+                for (const auto local : function.locals) {
+                    if (local->symbol == parameter->symbol) {
+                        m_bindings[local] = Type::Unknown;
+                    }
+                }
+            }
+        }
+    }
+
+    void Run(const ast::Program& program) {
+        do {
+            m_changed = false;
+            m_result.expressions.clear();
+            m_result.integerOperations = 0;
+            for (const auto& statement : program.statements) {
+                this->statement(statement.get());
+            }
+        } while (m_changed);
+    }
+
+private:
+    void update(Lattice& slot, Lattice value) {
+        const auto joined = join(slot, value);
+        if (joined != slot) {
+            slot = joined;
+            m_changed = true;
+        }
+    }
+
+    Lattice statement(const ast::Statement* statement) {
+        if (const auto let = dynamic_cast<const ast::LetStatement*>(statement)) {
+            const auto binding = m_resolution.Declaration(let);
+            if (dynamic_cast<const ast::FunctionLteral*>(let->value.get()) && binding) {
+                this->update(m_bindings[binding], Type::Function);
+            }
+            const auto value = this->expression(let->value.get());
+            if (binding) {
+                this->update(m_bindings[binding], value);
+            }
+            return Type::Unknown;
+        }
+        if (const auto ret = dynamic_cast<const ast::ReturnStatement*>(statement)) {
+            const auto value = this->expression(ret->returnValue.get());
+            if (!m_functions.empty()) {
+                this->update(m_returns[m_functions.back()], value);
+            }
+            return std::nullopt;
+        }
+        if (const auto exp = dynamic_cast<const ast::ExpressionStatement*>(statement)) {
+            return this->expression(exp->expression.get());
+        }
+        return Type::Unknown;
+    }
+
+    // Type of the value a block evaluates to; bottom when it always returns.
+    Lattice block(const ast::BlockStatement* block) {
+        if (!block || block->statements.empty()) {
+            return Type::Unknown;
+        }
+        Lattice value;
+        for (const auto& statement : block->statements) {
+            value = this->statement(statement.get());
+        }
+        return value;
+    }
+
+    Lattice expression(const ast::Expression* expression) {
+        const auto type = this->infer(expression);
+        if (type) {
+            m_result.expressions[expression] = *type;
+        }
+        return type;
+    }
+
+    Lattice infer(const ast::Expression* expression) {
+        if (!expression) {
+            return Type::Unknown;
+        }
+        if (dynamic_cast<const ast::IntegerLiteral*>(expression)) {
+            return Type::Integer;
+        }
+        if (dynamic_cast<const ast::Boolean*>(expression)) {
+            return Type::Boolean;
+        }
+        if (const auto identifier = dynamic_cast<const ast::Identifier*>(expression)) {
+            const auto binding = m_resolution.Use(identifier);
+            return binding ? m_bindings[binding] : Type::Unknown;
+        }
+        if (const auto prefix = dynamic_cast<const ast::PrefixExpression*>(expression)) {
+            const auto right = this->expression(prefix->right.get());
+            if (prefix->my_operator == ast::Operator::Bang) {
+                return Type::Boolean;
+            }
+            if (!right || *right == Type::Integer) {
+                return right;
+            }
+            return Type::Unknown;
+        }
+        if (const auto infix = dynamic_cast<const ast::InfixExpression*>(expression)) {
+            return this->infix(infix);
+        }
+        if (const auto ifExp = dynamic_cast<const ast::IfExpression*>(expression)) {
+            this->expression(ifExp->condition.get());
+            const auto consequence = this->block(ifExp->consequence.get());
+            const auto alternative = ifExp->alternative ? this->block(ifExp->alternative.get()) : Type::Unknown;
+            return join(consequence, alternative);
+        }
+        if (const auto literal = dynamic_cast<const ast::FunctionLteral*>(expression)) {
+            const auto function = m_resolution.Function(literal);
+            m_functions.push_back(function);
+            const auto value = this->block(literal->body.get());
+            this->update(m_returns[function], value);
+            m_functions.pop_back();
+            return Type::Function;
+        }
+        if (const auto call = dynamic_cast<const ast::CallExpression*>(expression)) {
+            return this->call(call);
+        }
+        return Type::Unknown;
+    }
+
+    Lattice infix(const ast::InfixExpression* infix) {
+        const auto left = this->expression(infix->left.get());
+        const auto right = this->expression(infix->right.get());
+        if (left == Type::Integer && right == Type::Integer) {
+            ++m_result.integerOperations;
+        }
+
+        const auto op = infix->my_operator;
+        if (op == ast::Operator::Equal || op == ast::Operator::NotEqual) {
+            return Type::Boolean;
+        }
+        if (!left || !right) {
+            return std::nullopt;
+        }
+        if (*left != Type::Integer || *right != Type::Integer) {
+            return Type::Unknown;
+        }
+        return op == ast::Operator::LessThan || op == ast::Operator::GreaterThan ? Type::Boolean : Type::Integer;
+    }
+
+    Lattice call(const ast::CallExpression* call) {
+        this->expression(call->function.get());
+        std::vector<Lattice> arguments;
+        for (const auto& argument : call->arguments) {
+            arguments.push_back(this->expression(argument.get()));
+        }
+
+        const auto callee = dynamic_cast<const ast::Identifier*>(call->function.get());
+        const auto binding = callee ? m_resolution.Use(callee) : nullptr;
+        if (!binding || !binding->function || !m_closed.contains(binding->function)) {
+            return Type::Unknown;
+        }
+        const auto literal = binding->function;
+        const auto function = m_resolution.Function(literal);
+        if (!function || literal->parameters.size() != arguments.size()) {
+            return Type::Unknown;
+        }
+
+        for (std::size_t i = 0; i < arguments.size(); ++i) {
+            for (const auto local : function->locals) {
+                if (local->symbol == literal->parameters[i]->symbol) {
+                    this->update(m_bindings[local], arguments[i]);
+                    break;
+                }
+            }
+        }
+        return m_returns[function];
+    }
+
+    const resolver::Resolution& m_resolution;
+    types::Inference& m_result;
+    bool m_changed{};
+    std::unordered_map<const ast::FunctionLteral*, const resolver::Binding*> m_closed;
+    std::unordered_map<const resolver::Binding*, Lattice> m_bindings;
+    std::unordered_map<const resolver::FunctionInfo*, Lattice> m_returns;
+    std::vector<const resolver::FunctionInfo*> m_functions;
+};
+
+} // namespace
+
+types::Inference types::Infer(const ast::Program& program, const resolver::Resolution& resolution) {
+    Inference result;
+    Inferer{resolution, result}.Run(program);
+    return result;
+}
+
+types::Fault types::Arithmetic(ast::Operator op, int64_t left, int64_t right, int64_t& result) {
+    int64_t value{};
+    bool overflow{};
+    if (op == ast::Operator::Plus) {
+        overflow = __builtin_add_overflow(left, right, &value);
+    } else if (op == ast::Operator::Minus) {
+        overflow = __builtin_sub_overflow(left, right, &value);
+    } else if (op == ast::Operator::Asterisk) {
+        overflow = __builtin_mul_overflow(left, right, &value);
+    } else if (op == ast::Operator::Slash) {
+        if (right == 0) {
+            return Fault::DivisionByZero;
+        }
+        overflow = left == INT64_MIN && right == -1;
+        value = overflow ? 0 : left / right;
+    }
+    if (overflow) {
+        return Fault::Overflow;
+    }
+    result = value;
+    return Fault::None;
+}
+
+std::string_view types::Describe(Fault fault) {
+    switch (fault) {
+    case Fault::Overflow:
+        return "integer overflow";
+    case Fault::DivisionByZero:
+        return "division by zero";
+    case Fault::None:
+        break;
+    }
+    return "";
+}
@@ -0,0 +1,58 @@
+#ifndef types_types_h
+#define types_types_h
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+
+#include <ast/ast.h>
+#include <resolver/resolver.h>
+
+namespace types
+{
+
+enum class Type {
+    Unknown,
+    Integer,
+    Boolean,
+    Function,
+};
+
+struct Inference {
+    Type Of(const ast::Expression* expression) const {
+        const auto it = this->expressions.find(expression);
+        return it == this->expressions.end() ? Type::Unknown : it->second;
+    }
+
+    // Both operands are known to be integers, so the operator needs no
+    // dynamic type check and can work on unboxed int64 values.
+    bool IntegerOnly(const ast::InfixExpression* infix) const {
+        return this->Of(infix->left.get()) == Type::Integer && this->Of(infix->right.get()) == Type::Integer;
+    }
+
+    std::unordered_map<const ast::Expression*, Type> expressions; // only known types are stored
+    uint32_t integerOperations{}; // InfixExpressions for which IntegerOnly holds
+};
+
+// Infers the type of every expression that always produces values of a
+// single type. Parameters of a function bound once by let and only ever called
+// directly take the join of their argument types over all call sites, and such
+// calls take the join of the callee's return values, iterated to a fixpoint so
+// that recursive integer functions are recognised.
+Inference Infer(const ast::Program& program, const resolver::Resolution& resolution);
+
+enum class Fault {
+    None,
+    Overflow,
+    DivisionByZero,
+};
+
+// Integer + - * / with the language's failure modes instead of undefined
+// behaviour. `result` is only written when Fault::None is returned.
+Fault Arithmetic(ast::Operator op, int64_t left, int64_t right, int64_t& result);
+
+std::string_view Describe(Fault fault);
+
+} // namespace types
+
+#endif // types_types_h
@@ -0,0 +1,30 @@
+#include <gtest/gtest.h>
+
+#include <ast/arena.h>
+#include <ast/ast.h>
+#include <lexer/lexer.h>
+#include <parser/parser.h>
+
+TEST(Arena, NodesShareOneArena) {
+    auto arena = std::make_shared<ast::Arena>(256);
+
+    auto first = ast::MakeNode<ast::IntegerLiteral>(arena);
+    auto second = ast::MakeNode<ast::IntegerLiteral>(arena);
+    EXPECT_GE(arena->allocated(), 2 * sizeof(ast::IntegerLiteral));
+
+    first->value = 1;
+    second->value = 2;
+    EXPECT_EQ(first->value, 1);
+    EXPECT_EQ(second->value, 2);
+}
+
+TEST(Arena, NodesOutliveParserAndProgram) {
+    std::shared_ptr<ast::Statement> statement;
+    {
+        auto p = Parser(lexer::Lexer("add(1, 2 * 3)"), 64);
+        auto program = p.ParseProgram();
+        ASSERT_EQ(program.statements.size(), 1);
+        statement = program.statements[0];
+    }
+    EXPECT_EQ(statement->String(), "add(1, (2 * 3))");
+}
@@ -1,19 +1,49 @@
 #include <gtest/gtest.h>
 
 #include <ast/ast.h>
+#include <token/token.h>
 
 TEST(Program, String) {
     auto letStatement = std::make_shared<ast::LetStatement>();
-    letStatement->token = token::Token(std::string{token::LET}, "let");
-    letStatement->name.token = token::Token(token::IDENT, "myVar");
     letStatement->name.value = "myVar";
 
     auto identifier = std::make_shared<ast::Identifier>();
-    identifier->token = token::Token(std::string{token::LET}, "anotherVar");
     identifier->value = "anotherVar";
     letStatement->value = std::move(identifier);
     
     auto program = ast::Program{};
     program.statements.emplace_back(std::move(letStatement)); 
     EXPECT_EQ(program.String(), "let myVar = anotherVar;");
-}
\ No newline at end of file
+}
+TEST(Program, OperatorSpelling) {
+    const std::vector<std::pair<std::string_view, ast::Operator>> tests{
+        {token::BANG, ast::Operator::Bang},
+        {token::MINUS, ast::Operator::Minus},
+        {token::PLUS, ast::Operator::Plus},
+        {token::ASTERISK, ast::Operator::Asterisk},
+        {token::SLASH, ast::Operator::Slash},
+        {token::LT, ast::Operator::LessThan},
+        {token::GT, ast::Operator::GreaterThan},
+        {token::EQ, ast::Operator::Equal},
+        {token::NOT_EQ, ast::Operator::NotEqual},
+    };
+    for (const auto& [type, op] : tests) {
+        EXPECT_EQ(ast::OperatorOf(type), op);
+        EXPECT_EQ(ast::Spelling(op), type);
+    }
+}
+
+TEST(Program, Census) {
+    auto letStatement = std::make_shared<ast::LetStatement>();
+    letStatement->name.value = "x";
+    auto infix = std::make_shared<ast::InfixExpression>();
+    infix->left = std::make_shared<ast::IntegerLiteral>();
+    infix->right = std::make_shared<ast::Identifier>();
+    letStatement->value = std::move(infix);
+
+    auto program = ast::Program{};
+    program.statements.emplace_back(std::move(letStatement));
+    const auto counts = ast::Census(program);
+    EXPECT_EQ(counts, (std::map<std::string_view, std::size_t>{
+                          {"LetStatement", 1}, {"InfixExpression", 1}, {"IntegerLiteral", 1}, {"Identifier", 2}}));
+}
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include <ast/ast.h>
+#include <emitter/emitter.h>
+#include <lexer/lexer.h>
+#include <parser/parser.h>
+
+namespace
+{
+
+std::string emit(const std::string& input, const emitter::Options& options = {}) {
+    auto p = Parser(lexer::Lexer(input));
+    const auto program = p.ParseProgram();
+    EXPECT_TRUE(p.Errors().empty());
+    return emitter::EmitCpp(program, options);
+}
+
+} // namespace
+
+TEST(Emitter, DefinesEntryPoints) {
+    const auto code = emit("1 + 2");
+
+    EXPECT_NE(code.find("namespace monkey_rt {"), std::string::npos);
+    EXPECT_NE(code.find("monkey_rt::Value monkey_program(const monkey_value* inputs = nullptr) {"), std::string::npos);
+    EXPECT_NE(code.find("extern \"C\" const char* monkey_run() {"), std::string::npos);
+    EXPECT_NE(code.find("extern \"C\" int monkey_execute("), std::string::npos);
+    EXPECT_NE(code.find("#ifdef MONKEY_MAIN"), std::string::npos);
+}
+
+TEST(Emitter, IntegerOnlyOperatorsSkipTypeChecks) {
+    const auto typed = emit("let fib = fn(n) { if (n < 2) { return n; } fib(n - 1) + fib(n - 2) }; fib(20);");
+    EXPECT_NE(typed.find("monkey_rt::ilt("), std::string::npos);
+    EXPECT_NE(typed.find("monkey_rt::isub("), std::string::npos);
+    EXPECT_NE(typed.find("monkey_rt::iadd("), std::string::npos);
+    EXPECT_EQ(typed.find("monkey_rt::infix("), std::string::npos);
+
+    const auto untyped = emit("let add = fn(a, b) { a + b }; let f = add; f(1, 2);");
+    EXPECT_NE(untyped.find("monkey_rt::infix(\"+\", "), std::string::npos);
+}
+
+TEST(Emitter, CapturedBindingsLiveInCells) {
+    const auto code = emit("let newAdder = fn(x) { fn(y) { x + y } }; newAdder(2)(3);");
+
+    EXPECT_NE(code.find("const auto c_newAdder_0 = monkey_rt::cell();"), std::string::npos);
+    EXPECT_NE(code.find("const auto c_x_1 = monkey_rt::cell(args[0]);"), std::string::npos);
+    EXPECT_NE(code.find("monkey_rt::Value v_y_2 = args[0];"), std::string::npos);
+}
+
+TEST(Emitter, NamesResolveThroughEnclosingScopes) {
+    const auto code = emit("let x = 1; let f = fn() { let y = x; let x = 2; y + z };");
+
+    EXPECT_NE(code.find("monkey_rt::load(\"x\", {&v_x_1, &(*c_x_0)})"), std::string::npos);
+    EXPECT_NE(code.find("monkey_rt::unbound(\"z\")"), std::string::npos);
+}
+
+TEST(Emitter, MemoizesPureRecursiveFunctions) {
+    const std::string input = "let fib = fn(n) { if (n < 2) { return n; } fib(n - 1) + fib(n - 2) }; "
+                              "let twice = fn(n) { n * 2 }; fib(twice(10));";
+
+    const auto plain = emit(input);
+    EXPECT_EQ(plain.find("= monkey_rt::memoize("), std::string::npos);
+
+    const auto memoized = emit(input, {.memoize = true});
+    EXPECT_NE(memoized.find("= monkey_rt::memoize(\"fib\", "), std::string::npos);
+    EXPECT_EQ(memoized.find("monkey_rt::memoize(\"twice\", "), std::string::npos);
+    EXPECT_NE(memoized.find("extern \"C\" const char* monkey_memo_stats() {"), std::string::npos);
+}
+
+TEST(Emitter, TracesFunctionCalls) {
+    const std::string input = "let add = fn(a, b) { a + b }; fn(x) { add(x, 1) }(2);";
+
+    const auto plain = emit(input);
+    EXPECT_EQ(plain.find("const monkey_rt::Span span{"), std::string::npos);
+
+    const auto traced = emit(input, {.trace = true});
+    EXPECT_NE(traced.find("const monkey_rt::Span span{\"program\"};"), std::string::npos);
+    EXPECT_NE(traced.find("const monkey_rt::Span span{\"add\"};"), std::string::npos);
+    EXPECT_NE(traced.find("const monkey_rt::Span span{\"fn\"};"), std::string::npos);
+}
+
+TEST(Emitter, ProfileFramesNameFunctionsAndPositions) {
+    const std::string input = "let add = fn(a, b) { a + b };\n  fn(x) { add(x, 1) }(2);";
+
+    EXPECT_EQ(emit(input).find("const monkey_rt::Frame frame{"), std::string::npos);
+
+    const auto profiled = emit(input, {.profile = true});
+    EXPECT_NE(profiled.find("const monkey_rt::Frame frame{\"program\"};"), std::string::npos);
+    EXPECT_NE(profiled.find("const monkey_rt::Frame frame{\"add:1:11\"};"), std::string::npos);
+    EXPECT_NE(profiled.find("const monkey_rt::Frame frame{\"fn:2:3\"};"), std::string::npos);
+}
+
+TEST(Emitter, InputsAreSetBeforeTheProgramRuns) {
+    const auto code = emit("let total = price * count; total", {.inputs = {"price", "count"}});
+
+    EXPECT_NE(code.find("    if (inputs) {\n"
+                        "        (*c_price_0) = monkey_rt::fromHost(inputs[0]);\n"
+                        "        (*c_count_0) = monkey_rt::fromHost(inputs[1]);\n"
+                        "    }\n"),
+              std::string::npos);
+}
@@ -1,8 +1,14 @@
 #include <gtest/gtest.h>
 
+#include <cstdio>
+#include <fstream>
+#include <sstream>
 #include <string_view>
+#include <type_traits>
+#include <utility>
 
 #include <lexer/lexer.h>
+#include <lexer/token_stream.h>
 #include <token/token.h>
 
 // Demonstrate some basic assertions.
@@ -112,4 +118,175 @@ if (5 < 10) {
         EXPECT_EQ(tok.type, token);
         EXPECT_EQ(tok.literal, value);
     }
-}
\ No newline at end of file
+}
+TEST(Lexer, DecodesIntegerLiterals) {
+    auto l = lexer::Lexer("0 42 9223372036854775807 9223372036854775808 123456789012345678901234567890");
+    const std::vector<int64_t> values{0, 42, INT64_MAX, 0, 0};
+    for (const auto value : values) {
+        const auto tok = l.NextToken();
+        EXPECT_EQ(tok.type, token::INT);
+        EXPECT_EQ(tok.value, value) << tok.literal;
+    }
+    EXPECT_EQ(l.NextToken().type, token::eof);
+
+    ASSERT_EQ(l.Errors().size(), 2);
+    EXPECT_EQ(l.Errors()[0], "1:26: integer literal 9223372036854775808 does not fit in 64 bits");
+    EXPECT_EQ(l.Errors()[1], "1:46: integer literal 123456789012345678901234567890 does not fit in 64 bits");
+}
+
+TEST(Lexer, TokensAreMovedNotCopied) {
+    static_assert(!std::is_copy_constructible_v<token::Token> && !std::is_copy_assignable_v<token::Token>);
+    static_assert(std::is_nothrow_move_constructible_v<token::Token> && std::is_nothrow_move_assignable_v<token::Token>);
+
+    auto l = lexer::Lexer("counter");
+    auto tok = l.NextToken();
+    const auto moved = std::move(tok);
+    EXPECT_EQ(moved.type, token::IDENT);
+    EXPECT_EQ(moved.literal, "counter");
+}
+
+TEST(Lexer, TokensStraddleChunks) {
+    const std::string input = "let fibonacci = fn(x) { if (x != 12345) { x } else { !-y == 9223372036854775807 } };";
+
+    std::vector<token::Token> expected;
+    auto whole = lexer::Lexer(input);
+    for (auto tok = whole.NextToken(); tok.type != token::eof; tok = whole.NextToken()) {
+        expected.push_back(std::move(tok));
+    }
+
+    for (const std::size_t chunkSize : {1, 2, 3, 7, 64}) {
+        std::size_t offset = 0;
+        auto streamed = lexer::Lexer([&](char* buffer, std::size_t size) {
+            const auto n = std::min(size, input.size() - offset);
+            input.copy(buffer, n, offset);
+            offset += n;
+            return n;
+        }, chunkSize);
+
+        for (const auto& want : expected) {
+            const auto tok = streamed.NextToken();
+            EXPECT_EQ(tok.type, want.type) << chunkSize;
+            EXPECT_EQ(tok.literal, want.literal) << chunkSize;
+            EXPECT_EQ(tok.value, want.value) << chunkSize;
+        }
+        EXPECT_EQ(streamed.NextToken().type, token::eof);
+    }
+}
+
+TEST(Lexer, FromStream) {
+    std::istringstream in{"let x = 10;\nx"};
+    auto l = lexer::FromStream(in, 4);
+
+    const std::vector<std::pair<std::string_view, std::string_view>> tests{
+        {token::LET, "let"},
+        {token::IDENT, "x"},
+        {token::ASSIGN, "="},
+        {token::INT, "10"},
+        {token::SEMICOLON, ";"},
+        {token::IDENT, "x"},
+        {token::eof, ""},
+    };
+    for (const auto& [type, literal] : tests) {
+        const auto tok = l.NextToken();
+        EXPECT_EQ(tok.type, type);
+        EXPECT_EQ(tok.literal, literal);
+    }
+}
+
+TEST(Lexer, FromFile) {
+    const std::string path = testing::TempDir() + "lexer_from_file.monkey";
+    std::ofstream{path} << "let x = 10;\nx";
+    auto l = lexer::FromFile(path, 4);
+    ASSERT_TRUE(l.has_value());
+
+    std::string literals;
+    for (auto tok = l->NextToken(); tok.type != token::eof; tok = l->NextToken()) {
+        literals += tok.literal + ' ';
+    }
+    EXPECT_EQ(literals, "let x = 10 ; x ");
+    EXPECT_EQ(l->Locate(12).line, 2);
+
+    std::ofstream{path, std::ios::trunc};
+    l = lexer::FromFile(path);
+    ASSERT_TRUE(l.has_value());
+    EXPECT_EQ(l->NextToken().type, token::eof);
+    std::remove(path.c_str());
+
+    EXPECT_FALSE(lexer::FromFile(path).has_value());
+}
+
+TEST(TokenStream, PeeksAheadAndTakesInOrder) {
+    auto tokens = lexer::TokenStream<4>(lexer::Lexer("let add = fn(x, y) { x + y };"));
+
+    EXPECT_EQ(tokens.Peek(3).literal, "fn");
+    EXPECT_EQ(tokens.Peek(1).literal, "add");
+
+    const std::vector<std::string_view> expected{"let", "add", "=", "fn", "(", "x", ",", "y", ")", "{", "x", "+", "y", "}", ";", ""};
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        if (i + 3 < expected.size()) {
+            EXPECT_EQ(tokens.Peek(3).literal, expected[i + 3]);
+        }
+        EXPECT_EQ(tokens.Peek().literal, expected[i]);
+        EXPECT_EQ(tokens.Next().literal, expected[i]);
+    }
+    EXPECT_EQ(tokens.Next().type, token::eof);
+}
+
+TEST(Lexer, LocatesTokens) {
+    const std::string input = "let x = 5;\n\n  let y =\n\tx + 10;\n";
+    const std::vector<std::tuple<std::string_view, uint32_t, uint32_t>> expected{
+        {"let", 1, 1}, {"x", 1, 5}, {"=", 1, 7}, {"5", 1, 9}, {";", 1, 10},
+        {"let", 3, 3}, {"y", 3, 7}, {"=", 3, 9},
+        {"x", 4, 2}, {"+", 4, 4}, {"10", 4, 6}, {";", 4, 8},
+    };
+
+    for (const std::size_t chunkSize : {0, 1, 3}) {
+        std::size_t offset = 0;
+        auto l = chunkSize == 0 ? lexer::Lexer(input) : lexer::Lexer([&](char* buffer, std::size_t size) {
+            const auto n = std::min(size, input.size() - offset);
+            input.copy(buffer, n, offset);
+            offset += n;
+            return n;
+        }, chunkSize);
+
+        // Tokens are located as a parser would, while they are recent.
+        std::vector<token::Token> tokens;
+        for (auto tok = l.NextToken(); tok.type != token::eof; tok = l.NextToken()) {
+            ASSERT_LT(tokens.size(), expected.size());
+            const auto [literal, line, column] = expected[tokens.size()];
+            const auto location = l.Locate(tok.offset);
+            EXPECT_EQ(tok.literal, literal);
+            EXPECT_EQ(location.line, line) << literal << ' ' << chunkSize;
+            EXPECT_EQ(location.column, column) << literal << ' ' << chunkSize;
+            tokens.push_back(std::move(tok));
+        }
+        ASSERT_EQ(tokens.size(), expected.size());
+    }
+}
+
+TEST(Lexer, CountsLinesOfDroppedInput) {
+    std::string input;
+    for (int i = 0; i < 5000; ++i) {
+        input += "let x = 1;\n";
+    }
+    std::size_t offset = 0;
+    auto l = lexer::Lexer([&](char* buffer, std::size_t size) {
+        const auto n = std::min(size, input.size() - offset);
+        input.copy(buffer, n, offset);
+        offset += n;
+        return n;
+    }, 64);
+
+    uint32_t line = 1;
+    for (auto tok = l.NextToken(); tok.type != token::eof; tok = l.NextToken()) {
+        const auto location = l.Locate(tok.offset);
+        ASSERT_EQ(location.line, line) << tok.offset;
+        if (tok.type == token::SEMICOLON) {
+            EXPECT_EQ(location.column, 10);
+            ++line;
+        }
+    }
+    EXPECT_EQ(line, 5001);
+    // Only the line starts of recent tokens are kept.
+    EXPECT_EQ(l.Locate(0).line, 0);
+}
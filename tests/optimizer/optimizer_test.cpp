@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+
+#include <ast/ast.h>
+#include <lexer/lexer.h>
+#include <optimizer/optimizer.h>
+#include <parser/parser.h>
+
+namespace
+{
+
+ast::Program parse(const std::string& input) {
+    auto p = Parser(lexer::Lexer(input));
+    auto program = p.ParseProgram();
+    EXPECT_TRUE(p.Errors().empty());
+    return program;
+}
+
+std::string lastStatement(const ast::Program& program) {
+    return program.statements.back()->String();
+}
+
+} // namespace
+
+TEST(Optimizer, InlinesAndFoldsSmallFunctions) {
+    const std::vector<std::tuple<std::string, std::string, uint32_t>> tests{
+        {"let add = fn(a, b) { a + b }; add(1, 2);", "3", 1},
+        {"let add = fn(a, b) { return a + b; }; let x = 1; add(x, 2 * 3);", "(x + 6)", 1},
+        {"let sq = fn(x) { x * x }; let f = fn(y) { sq(y) + 1 }; f(3);", "10", 2},
+        {"let sq = fn(x) { x * x }; sq(y + 1);", "sq((y + 1))", 0},
+        {"let first = fn(a, b) { a }; first(1, g());", "first(1, g())", 0},
+        {"let max = fn(a, b) { if (a > b) { a } else { b } }; max(3, 7);", "7", 1},
+    };
+    for (const auto& [input, expected, inlined] : tests) {
+        auto program = parse(input);
+        const auto stats = optimizer::Optimize(program);
+        EXPECT_EQ(lastStatement(program), expected) << input;
+        EXPECT_EQ(stats.inlinedCalls, inlined) << input;
+    }
+}
+
+TEST(Optimizer, KeepsCallsThatCannotBeInlined) {
+    const std::vector<std::pair<std::string, std::string>> tests{
+        {"let f = fn(n) { f(n) }; f(1);", "f(1)"},
+        {"let f = fn() { 1 }; let f = fn() { 2 }; f();", "f()"},
+        {"let f = fn(a) { fn() { a } }; f(1);", "f(1)"},
+        {"let k = 1; let f = fn(a) { a + k }; let g = fn(k) { f(k) };", "let g = fn(k, ) f(k);"},
+        {"let f = fn(a, b) { a + b }; f(1);", "f(1)"},
+        {"let k = fn(a) { 1 }; k(zz);", "k(zz)"},
+        {"let k = fn(a, b) { if (b) { a } else { 0 } }; k(true + 1, false);", "k((true + 1), false)"},
+    };
+    for (const auto& [input, expected] : tests) {
+        auto program = parse(input);
+        optimizer::Optimize(program);
+        EXPECT_EQ(lastStatement(program), expected) << input;
+    }
+}
+
+TEST(Optimizer, FoldConstants) {
+    const std::vector<std::pair<std::string, std::string>> tests{
+        {"1 + 2 * 3", "7"},
+        {"-(5 + 5)", "-10"},
+        {"!true", "false"},
+        {"!5", "false"},
+        {"1 < 2 == true", "true"},
+        {"true != false", "true"},
+        {"if (1 < 2) { 10 } else { 20 }", "10"},
+        {"if (false) { 10 }", "iffalse 10"},
+        {"10 / 0", "(10 / 0)"},
+        {"9223372036854775807 + 1", "(9223372036854775807 + 1)"},
+        {"1 + true", "(1 + true)"},
+        {"x + 2 * 3", "(x + 6)"},
+    };
+    for (const auto& [input, expected] : tests) {
+        auto program = parse(input);
+        optimizer::FoldConstants(program);
+        EXPECT_EQ(program.String(), expected) << input;
+    }
+}
+
+TEST(Optimizer, EliminateDeadCode) {
+    const std::vector<std::tuple<std::string, std::string, uint32_t>> tests{
+        {"fn(x) { return x; x + 1; 5 }", "fn(x, ) return x;", 6},
+        {"fn(x) { 5; true; x; x + 1 }", "fn(x, ) (x + 1)", 6},
+        {"fn(x) { let y = x == 1; let z = f(x); x }", "fn(x, ) let z = f(x);x", 5},
+        {"let a = 1; let b = a; 0", "0", 6},
+        {"fn() { y; g(); 1 + true; 0 }", "fn() yg()(1 + true)0", 0},
+        {"fn(x) { let y = 1; let y = 2; y }", "fn(x, ) let y = 1;let y = 2;y", 0},
+    };
+    for (const auto& [input, expected, removed] : tests) {
+        auto program = parse(input);
+        EXPECT_EQ(optimizer::EliminateDeadCode(program), removed) << input;
+        EXPECT_EQ(program.String(), expected) << input;
+    }
+}
+
+TEST(Optimizer, KeepsLetsReadBeforeTheyAreBound) {
+    const std::vector<std::pair<std::string, std::string>> tests{
+        {"let isEven = fn(n) { let m = n; if (m == 0) { true } else { isOdd(m - 1) } }; "
+         "let isOdd = fn(n) { if (n == 0) { false } else { isEven(n - 1) } }; isEven(10);",
+         "let isOdd = "},
+        {"let f = fn() { let g = fn() { x }; let x = 1; g() }; f();", "let x = 1;"},
+    };
+    for (const auto& [input, kept] : tests) {
+        auto program = parse(input);
+        optimizer::Optimize(program);
+        EXPECT_NE(program.String().find(kept), std::string::npos) << program.String();
+    }
+}
+
+TEST(Optimizer, InlinedHelpersAreRemoved) {
+    auto program = parse("let add = fn(a, b) { a + b }; let main = fn(x) { add(x, 1) }; main(2);");
+    const auto stats = optimizer::Optimize(program);
+
+    EXPECT_EQ(stats.inlinedCalls, 2);
+    EXPECT_EQ(program.String(), "3");
+    EXPECT_GT(stats.removedNodes, 0);
+}
+
+TEST(Optimizer, AllocatesNewNodesInTheProgramArena) {
+    auto program = parse("let add = fn(a, b) { a + b }; add(1, 2); 3 * 4;");
+    ASSERT_NE(program.arena, nullptr);
+    const auto parsed = program.arena->allocated();
+    optimizer::Optimize(program);
+    EXPECT_GT(program.arena->allocated(), parsed);
+
+    // Programs built by hand get an arena of their own.
+    ast::Program built;
+    auto statement = std::make_shared<ast::ExpressionStatement>();
+    auto infix = std::make_shared<ast::InfixExpression>();
+    infix->left = std::make_shared<ast::IntegerLiteral>();
+    infix->my_operator = ast::Operator::Plus;
+    infix->right = std::make_shared<ast::IntegerLiteral>();
+    statement->expression = infix;
+    built.statements.push_back(statement);
+    EXPECT_EQ(optimizer::FoldConstants(built), 1);
+    ASSERT_NE(built.arena, nullptr);
+    EXPECT_GT(built.arena->allocated(), 0);
+}
@@ -64,7 +64,7 @@ void testInfixExpression(std::shared_ptr<ast::Expression> exp, Left left, std::s
     
     testLiteralExpression(opExpr->left, left);
 
-    EXPECT_EQ(opExpr->my_operator, cur_operator);
+    EXPECT_EQ(ast::Spelling(opExpr->my_operator), cur_operator);
 
     testLiteralExpression(opExpr->right, right);
 }
@@ -124,6 +124,30 @@ TEST(Parser, Return) {
     }
 }
 
+TEST(Parser, LetAndReturnValues) {
+    const std::string input = R"(
+        let x = 5;
+        let y = true;
+        let foobar = y;
+        return x + 10;
+    )";
+
+    auto l = lexer::Lexer(input);
+    auto p = Parser(std::move(l));
+    auto program = p.ParseProgram();
+    checkParserError(p);
+
+    ASSERT_EQ(program.statements.size(), 4);
+
+    testLiteralExpression(dynamic_cast<ast::LetStatement*>(program.statements[0].get())->value, 5);
+    testLiteralExpression(dynamic_cast<ast::LetStatement*>(program.statements[1].get())->value, true);
+    testLiteralExpression(dynamic_cast<ast::LetStatement*>(program.statements[2].get())->value, "y");
+
+    const auto returnStmt = dynamic_cast<ast::ReturnStatement*>(program.statements[3].get());
+    ASSERT_TRUE(!!returnStmt);
+    testInfixExpression(returnStmt->returnValue, "x", "+", 10);
+}
+
 TEST(ParseProgram, Identifier) {
     const std::string input = "foobar;";
 
@@ -181,7 +205,7 @@ TEST(ParseProgram, PrefixExpressions) {
         const auto exp = dynamic_cast<ast::PrefixExpression*>(stmt->expression.get());
         ASSERT_TRUE(!!exp);
 
-        EXPECT_EQ(exp->my_operator, std::get<1>(one_test));
+        EXPECT_EQ(ast::Spelling(exp->my_operator), std::get<1>(one_test));
         testIntegerLiteral(exp->right, std::get<2>(one_test));
     }
     const std::vector<std::tuple<std::string, std::string, bool>> prefixTestsBool{{"!true;", "!", true},
@@ -200,7 +224,7 @@ TEST(ParseProgram, PrefixExpressions) {
         const auto exp = dynamic_cast<ast::PrefixExpression*>(stmt->expression.get());
         ASSERT_TRUE(!!exp);
 
-        EXPECT_EQ(exp->my_operator, std::get<1>(one_test));
+        EXPECT_EQ(ast::Spelling(exp->my_operator), std::get<1>(one_test));
         testLiteralExpression(exp->right, std::get<2>(one_test));
     }
 }
@@ -232,7 +256,7 @@ std::vector<std::tuple<std::string, bool, std::string, bool>> infixTestsBool{{"t
 
         testLiteralExpression(exp->left, leftValue);
 
-        EXPECT_EQ(exp->my_operator, my_operator);
+        EXPECT_EQ(ast::Spelling(exp->my_operator), my_operator);
 
         testLiteralExpression(exp->right, rightValue);
     }
@@ -253,7 +277,7 @@ std::vector<std::tuple<std::string, bool, std::string, bool>> infixTestsBool{{"t
 
         testLiteralExpression(exp->left, leftValue);
 
-        EXPECT_EQ(exp->my_operator, my_operator);
+        EXPECT_EQ(ast::Spelling(exp->my_operator), my_operator);
 
         testLiteralExpression(exp->right, rightValue);
     }
@@ -507,4 +531,128 @@ TEST(ParseProgram, CallExpression) {
     testLiteralExpression(exp->arguments[0], 1);
     testInfixExpression(exp->arguments[1], 2, "*", 3);
     testInfixExpression(exp->arguments[2], 4, "+", 5);
-}
\ No newline at end of file
+}
+TEST(ParseProgram, DeeplyNestedExpressions) {
+    constexpr std::size_t depth = 50000;
+    const std::vector<std::pair<std::string, std::string>> tests{
+        {std::string(depth, '(') + "1" + std::string(depth, ')'), "1"},
+        {std::string(depth, '-') + "x", "-x"},
+        {"x" + [] {
+            std::string chain;
+            for (std::size_t i = 0; i < depth; ++i) {
+                chain += "+1";
+            }
+            return chain;
+        }(), "x + 1"},
+    };
+    for (const auto& [input, innermost] : tests) {
+        auto p = Parser(lexer::Lexer(input));
+        auto program = p.ParseProgram();
+        checkParserError(p);
+        ASSERT_EQ(program.statements.size(), 1);
+
+        const auto printed = program.String();
+        EXPECT_NE(printed.find(innermost), std::string::npos);
+        EXPECT_EQ(ast::Depth(program), input[0] == '(' ? 2 : depth + 2);
+    }
+}
+
+TEST(ParseProgram, DeeplyNestedCalls) {
+    constexpr std::size_t depth = 20000;
+    std::string input;
+    for (std::size_t i = 0; i < depth; ++i) {
+        input += "f(1, ";
+    }
+    input += "2" + std::string(depth, ')');
+
+    auto p = Parser(lexer::Lexer(input));
+    auto program = p.ParseProgram();
+    checkParserError(p);
+    ASSERT_EQ(program.statements.size(), 1);
+
+    const auto printed = program.String();
+    EXPECT_EQ(printed.substr(0, 12), "f(1, f(1, f(");
+    EXPECT_EQ(printed.substr(printed.size() - depth - 4), "1, 2" + std::string(depth, ')'));
+}
+
+TEST(ParseProgram, BlockNestingIsLimited) {
+    std::string nested;
+    for (std::size_t i = 0; i < MaxBlockDepth; ++i) {
+        nested += "if (x) { ";
+    }
+    nested += "1" + std::string(MaxBlockDepth, '}');
+
+    auto p = Parser(lexer::Lexer(nested + "; 2"));
+    auto program = p.ParseProgram();
+    checkParserError(p);
+    EXPECT_EQ(program.statements.size(), 2);
+
+    auto deeper = Parser(lexer::Lexer("if (x) { " + nested + " }; 2"));
+    program = deeper.ParseProgram();
+    ASSERT_EQ(deeper.Errors().size(), 1);
+    EXPECT_EQ(deeper.Errors()[0], fmt::format("1:{}: blocks nested deeper than {}", 9 * MaxBlockDepth + 8, MaxBlockDepth));
+    EXPECT_EQ(program.statements.size(), 1);
+}
+
+TEST(ParseProgram, IntegerLiteralOverflow) {
+    auto p = Parser(lexer::Lexer("let x = 1; let y = 99999999999999999999 + x;"));
+    const auto program = p.ParseProgram();
+
+    EXPECT_EQ(program.statements.size(), 2);
+    ASSERT_EQ(p.Errors().size(), 1);
+    EXPECT_EQ(p.Errors()[0], "1:20: integer literal 99999999999999999999 does not fit in 64 bits");
+}
+
+TEST(ParseProgram, StatementsParseWhileInputArrives) {
+    const std::string input = "let a = 1; let b = a + 2; b * 3 * 4 * 5";
+    std::size_t offset = 0;
+    auto p = Parser(lexer::Lexer([&](char* buffer, std::size_t size) {
+        const auto n = std::min(size, input.size() - offset);
+        input.copy(buffer, n, offset);
+        offset += n;
+        return n;
+    }, 4));
+
+    std::vector<std::string> statements;
+    std::vector<std::size_t> consumed;
+    while (const auto statement = p.ParseNextStatement()) {
+        statements.push_back(statement->String());
+        consumed.push_back(offset);
+    }
+    checkParserError(p);
+
+    EXPECT_EQ(statements, (std::vector<std::string>{"let a = 1;", "let b = (a + 2);", "(((b * 3) * 4) * 5)"}));
+    EXPECT_LT(consumed[0], input.size());
+    EXPECT_LT(consumed[1], input.size());
+}
+
+TEST(ParseProgram, ErrorsCarryLocations) {
+    auto p = Parser(lexer::Lexer("let x = 1;\nlet = 2;\n  let y = );"));
+    p.ParseProgram();
+
+    ASSERT_EQ(p.Errors().size(), 2);
+    EXPECT_EQ(p.Errors()[0], "2:5: expected next token to be IDENT, got = instead");
+    EXPECT_EQ(p.Errors()[1], "3:11: no prefix parse function for ) found");
+}
+
+TEST(ParseProgram, RecoversAtStatementBoundaries) {
+    auto p = Parser(lexer::Lexer("let = 1; let a = 2;\n"
+                                 "if (a { a } let b = 3;\n"
+                                 "let f = fn(x) { let = x; return x; };\n"
+                                 "return a +; b"));
+    const auto program = p.ParseProgram();
+
+    ASSERT_EQ(p.Errors().size(), 4);
+    EXPECT_EQ(p.Errors()[0], "1:5: expected next token to be IDENT, got = instead");
+    EXPECT_EQ(p.Errors()[1], "2:7: expected next token to be ), got { instead");
+    EXPECT_EQ(p.Errors()[2], "3:21: expected next token to be IDENT, got = instead");
+    EXPECT_EQ(p.Errors()[3], "4:11: no prefix parse function for ; found");
+
+    ASSERT_EQ(program.statements.size(), 3);
+    for (const auto& statement : program.statements) {
+        ASSERT_NE(statement, nullptr);
+    }
+    EXPECT_EQ(program.statements[0]->String(), "let a = 2;");
+    EXPECT_EQ(program.statements[1]->String(), "let b = 3;");
+    EXPECT_EQ(program.statements[2]->String(), "b");
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <ast/ast.h>
+#include <lexer/lexer.h>
+#include <parser/parser.h>
+#include <purity/purity.h>
+#include <resolver/resolver.h>
+
+namespace
+{
+
+ast::Program parse(const std::string& input) {
+    auto p = Parser(lexer::Lexer(input));
+    auto program = p.ParseProgram();
+    EXPECT_TRUE(p.Errors().empty());
+    return program;
+}
+
+const ast::FunctionLteral* letValue(const ast::Program& program, std::size_t index) {
+    const auto let = dynamic_cast<const ast::LetStatement*>(program.statements[index].get());
+    return dynamic_cast<const ast::FunctionLteral*>(let->value.get());
+}
+
+} // namespace
+
+TEST(Purity, RecursiveFunctionIsMemoizable) {
+    const auto program = parse("let fib = fn(n) { if (n < 2) { return n; } fib(n - 1) + fib(n - 2) }; fib(20);");
+    const auto resolution = resolver::Resolve(program);
+    const auto analysis = purity::Analyze(program, resolution);
+
+    EXPECT_TRUE(analysis.Pure(letValue(program, 0)));
+    EXPECT_TRUE(analysis.Memoizable(letValue(program, 0)));
+}
+
+TEST(Purity, NonRecursiveFunctionIsNotMemoizable) {
+    const auto program = parse("let limit = 10; let clamp = fn(n) { if (n > limit) { limit } else { n } };");
+    const auto resolution = resolver::Resolve(program);
+    const auto analysis = purity::Analyze(program, resolution);
+
+    EXPECT_TRUE(analysis.Pure(letValue(program, 1)));
+    EXPECT_FALSE(analysis.Memoizable(letValue(program, 1)));
+}
+
+TEST(Purity, MutableOrUnknownNamesMakeFunctionsImpure) {
+    const auto program = parse(R"(
+        let base = 1;
+        let f = fn(n) { if (n < 1) { base } else { f(n - 1) } };
+        let base = 2;
+        let g = fn(n) { if (n < 1) { len(n) } else { g(n - 1) } };
+        let h = fn(n) { if (n < 1) { 0 } else { h(n - 1) + f(n) } };
+    )");
+    const auto resolution = resolver::Resolve(program);
+    const auto analysis = purity::Analyze(program, resolution);
+
+    EXPECT_FALSE(analysis.Pure(letValue(program, 1)));
+    EXPECT_FALSE(analysis.Pure(letValue(program, 3)));
+    EXPECT_FALSE(analysis.Pure(letValue(program, 4)));
+    EXPECT_FALSE(analysis.Memoizable(letValue(program, 4)));
+}
+
+TEST(Purity, MutuallyRecursiveFunctionsStayPure) {
+    const auto program = parse(R"(
+        let even = fn(n) { if (n == 0) { true } else { odd(n - 1) } };
+        let odd = fn(n) { if (n == 0) { false } else { even(n - 1) } };
+    )");
+    const auto resolution = resolver::Resolve(program);
+    const auto analysis = purity::Analyze(program, resolution);
+
+    EXPECT_TRUE(analysis.Pure(letValue(program, 0)));
+    EXPECT_TRUE(analysis.Pure(letValue(program, 1)));
+}
@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+
+#include <ast/ast.h>
+#include <lexer/lexer.h>
+#include <parser/parser.h>
+#include <resolver/resolver.h>
+
+namespace
+{
+
+ast::Program parse(const std::string& input) {
+    auto p = Parser(lexer::Lexer(input));
+    auto program = p.ParseProgram();
+    EXPECT_TRUE(p.Errors().empty());
+    return program;
+}
+
+const resolver::Binding* local(const resolver::FunctionInfo* function, std::string_view name) {
+    for (const auto binding : function->locals) {
+        if (binding->name == name) {
+            return binding;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+TEST(Resolver, NonCapturedLocalsGetFrameSlots) {
+    const auto program = parse("let add = fn(a, b) { let c = a + b; c };");
+    const auto resolution = resolver::Resolve(program);
+
+    ASSERT_EQ(resolution.globals.size(), 1);
+    EXPECT_EQ(resolution.globals[0]->name, "add");
+    EXPECT_EQ(resolution.globals[0]->storage, resolver::Storage::Global);
+
+    ASSERT_EQ(resolution.functions.size(), 1);
+    const auto& add = resolution.functions[0];
+    EXPECT_FALSE(add.LeaksLocals());
+    EXPECT_EQ(add.frameSlots, 3);
+
+    const auto c = local(&add, "c");
+    ASSERT_TRUE(c);
+    EXPECT_EQ(c->storage, resolver::Storage::Frame);
+    EXPECT_EQ(c->slot, 2);
+    EXPECT_EQ(c->reads, 1);
+}
+
+TEST(Resolver, ReturnedClosureBoxesCapturedParameter) {
+    const std::vector<std::string> inputs{
+        "let adder = fn(x) { fn(y) { x + y } };",
+        "let adder = fn(x) { return fn(y) { x + y }; };",
+        "let adder = fn(x) { let g = fn(y) { x + y }; g };",
+        "let adder = fn(x) { apply(fn(y) { x + y }); 0 };",
+    };
+    for (const auto& input : inputs) {
+        const auto program = parse(input);
+        const auto resolution = resolver::Resolve(program);
+
+        ASSERT_EQ(resolution.functions.size(), 2) << input;
+        const auto outer = &resolution.functions[0];
+        EXPECT_TRUE(outer->LeaksLocals()) << input;
+        EXPECT_TRUE(resolution.functions[1].escapes) << input;
+        EXPECT_EQ(local(outer, "x")->storage, resolver::Storage::Boxed) << input;
+    }
+}
+
+TEST(Resolver, LocallyCalledClosureKeepsFrameSlots) {
+    const auto program = parse("let apply = fn(x, y) { let g = fn() { x }; g(); fn() { y } };");
+    const auto resolution = resolver::Resolve(program);
+
+    ASSERT_EQ(resolution.functions.size(), 3);
+    const auto outer = &resolution.functions[0];
+    EXPECT_FALSE(resolution.functions[1].escapes);
+    EXPECT_TRUE(resolution.functions[2].escapes);
+
+    EXPECT_EQ(local(outer, "x")->storage, resolver::Storage::Frame);
+    EXPECT_EQ(local(outer, "y")->storage, resolver::Storage::Boxed);
+    EXPECT_EQ(local(outer, "g")->storage, resolver::Storage::Frame);
+    EXPECT_EQ(outer->frameSlots, 2);
+    EXPECT_EQ(outer->boxedSlots, 1);
+}
+
+TEST(Resolver, LocalRecursionKeepsFrameSlots) {
+    const auto program = parse("let count = fn(n) { let go = fn(i) { if (i == 0) { 0 } else { go(i - 1) } }; go(n) };");
+    const auto resolution = resolver::Resolve(program);
+
+    ASSERT_EQ(resolution.functions.size(), 2);
+    EXPECT_FALSE(resolution.functions[1].escapes);
+    EXPECT_EQ(local(&resolution.functions[0], "go")->storage, resolver::Storage::Frame);
+
+    const auto returned = parse("let count = fn(n) { let go = fn(i) { fn() { go(i) } }; go(n) };");
+    const auto escaping = resolver::Resolve(returned);
+    ASSERT_EQ(escaping.functions.size(), 3);
+    EXPECT_TRUE(escaping.functions[1].escapes);
+    EXPECT_EQ(local(&escaping.functions[0], "go")->storage, resolver::Storage::Boxed);
+}
+
+TEST(Resolver, LateReadsCountAsCaptures) {
+    const auto program = parse(
+        "let make = fn() { let a = fn(n) { b(n) }; let b = fn(n) { a(n) }; a };");
+    const auto resolution = resolver::Resolve(program);
+
+    ASSERT_EQ(resolution.functions.size(), 3);
+    const auto make = &resolution.functions[0];
+    EXPECT_TRUE(resolution.functions[1].escapes);
+    EXPECT_TRUE(resolution.functions[2].escapes);
+    EXPECT_EQ(local(make, "a")->storage, resolver::Storage::Boxed);
+    EXPECT_EQ(local(make, "b")->storage, resolver::Storage::Boxed);
+    EXPECT_EQ(local(make, "b")->calls, 1);
+}
+
+TEST(Resolver, RecursiveLetResolvesToItself) {
+    const auto program = parse("let fib = fn(n) { if (n < 2) { n } else { fib(n - 1) + fib(n - 2) } }; fib(10);");
+    const auto resolution = resolver::Resolve(program);
+
+    ASSERT_EQ(resolution.globals.size(), 1);
+    const auto fib = resolution.globals[0];
+    EXPECT_EQ(fib->reads, 3);
+    EXPECT_EQ(fib->calls, 3);
+    EXPECT_EQ(fib->function, resolution.functions[0].literal);
+
+    const auto call = dynamic_cast<ast::CallExpression*>(
+        dynamic_cast<ast::ExpressionStatement*>(program.statements[1].get())->expression.get());
+    ASSERT_TRUE(call);
+    EXPECT_EQ(resolution.Use(dynamic_cast<ast::Identifier*>(call->function.get())), fib);
+}
+
+TEST(Resolver, SessionKeepsGlobalsAcrossPieces) {
+    resolver::Session session;
+    const auto first = parse("let a = 1; let f = fn(x) { x + a + later };");
+    const auto firstResolution = resolver::Resolve(first, session);
+    ASSERT_EQ(firstResolution.globals.size(), 2);
+    EXPECT_TRUE(firstResolution.unbound.empty());
+    const auto a = firstResolution.globals[0];
+
+    const auto second = parse("let later = 2; f(a) + b; let a = 3;");
+    const auto resolution = resolver::Resolve(second, session);
+    ASSERT_EQ(resolution.globals.size(), 3);
+    EXPECT_EQ(resolution.globals[0], a);
+    EXPECT_EQ(resolution.globals[2]->name, "later");
+    EXPECT_EQ(resolution.globals[2]->slot, 2);
+    EXPECT_EQ(a->declarations, 2);
+    EXPECT_EQ(a->reads, 2);
+
+    const auto call = dynamic_cast<ast::ExpressionStatement*>(second.statements[1].get());
+    const auto infix = dynamic_cast<ast::InfixExpression*>(call->expression.get());
+    const auto f = dynamic_cast<ast::CallExpression*>(infix->left.get());
+    EXPECT_EQ(resolution.Use(dynamic_cast<ast::Identifier*>(f->function.get())), resolution.globals[1]);
+    ASSERT_EQ(resolution.unbound.size(), 1);
+    EXPECT_EQ(resolution.unbound[0]->value, "b");
+
+    // The literal bound to f outlives the piece that declared it.
+    EXPECT_NE(session.functions.at(resolution.globals[1]), nullptr);
+    EXPECT_EQ(resolution.globals[1]->function, dynamic_cast<ast::LetStatement*>(first.statements[1].get())->value.get());
+}
+
+TEST(Resolver, SessionRollsBackThePieceResolvedLast) {
+    resolver::Session session;
+    const auto first = parse("let a = 1; let f = fn(x) { x + a };");
+    const auto firstResolution = resolver::Resolve(first, session);
+    const auto a = firstResolution.globals[0];
+    const auto f = firstResolution.globals[1];
+    const auto function = session.functions.at(f);
+
+    const auto second = parse("let b = a; let f = fn() { a }; let a = 2; c");
+    const auto resolution = resolver::Resolve(second, session);
+    ASSERT_EQ(resolution.unbound.size(), 1);
+    EXPECT_EQ(session.globals.size(), 3);
+    EXPECT_EQ(a->declarations, 2);
+    session.Rollback();
+
+    EXPECT_EQ(session.globals.size(), 2);
+    EXPECT_FALSE(session.names.contains(symbols::Intern("b")));
+    EXPECT_EQ(a->declarations, 1);
+    EXPECT_EQ(a->reads, 1);
+    EXPECT_EQ(f->function, dynamic_cast<ast::LetStatement*>(first.statements[1].get())->value.get());
+    EXPECT_EQ(session.functions.at(f), function);
+
+    // The next piece sees the session as it was before the one rolled back.
+    const auto third = parse("let b = 5; b");
+    EXPECT_EQ(resolver::Resolve(third, session).globals.back()->slot, 2);
+}
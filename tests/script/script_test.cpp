@@ -0,0 +1,246 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <script/script.h>
+#include <symbols/symbols.h>
+
+TEST(CompiledScript, ExecutesWithDifferentInputs) {
+    std::vector<std::string> errors;
+    const auto script = script::CompiledScript::Compile(
+        "let limit = limit * 2; let under = fn(n) { n < limit }; if (under(amount)) { amount } else { fail }",
+        {"amount", "limit", "fail"}, errors);
+    ASSERT_NE(script, nullptr) << (errors.empty() ? "" : errors[0]);
+    EXPECT_EQ(script->Inputs(), (std::vector<std::string>{"amount", "limit", "fail"}));
+
+    const auto under = script->Execute(std::vector<script::Value>{int64_t{5}, int64_t{10}, false});
+    EXPECT_EQ(under.error, "");
+    EXPECT_EQ(under.value, script::Value{int64_t{5}});
+    const auto over = script->Execute(std::vector<script::Value>{int64_t{50}, int64_t{10}, false});
+    EXPECT_EQ(over.value, script::Value{false});
+    const auto missing = script->Execute(std::vector<script::Value>{int64_t{50}});
+    EXPECT_EQ(missing.error, "type mismatch: NULL * INTEGER");
+}
+
+TEST(CompiledScript, ExecutesOnSeveralThreadsAtOnce) {
+    std::vector<std::string> errors;
+    const auto script = script::CompiledScript::Compile(
+        "let limit = limit * 2; let under = fn(n) { n < limit };"
+        "let count = fn(n) { if (n == 0) { 0 } else { 1 + count(n - 1) } };"
+        "if (under(amount)) { amount + count(amount) } else { fail }",
+        {"amount", "limit", "fail"}, errors);
+    ASSERT_NE(script, nullptr) << (errors.empty() ? "" : errors[0]);
+
+    // Every execution has globals and a heap of its own, so no thread sees
+    // another's values and each leaves nothing behind.
+    constexpr int Threads = 8;
+    constexpr int Rounds = 200;
+    std::vector<int> wrong(Threads);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < Threads; ++i) {
+        threads.emplace_back([&, i] {
+            const int64_t amount = i % 2 == 0 ? i : 100 + i;
+            const auto expected = amount < 8 ? script::Value{2 * amount} : script::Value{false};
+            for (int round = 0; round < Rounds; ++round) {
+                const auto result = script->Execute(std::vector<script::Value>{amount, int64_t{4}, false});
+                if (result.value != expected || !result.error.empty() || result.usage.live != 0 ||
+                    result.usage.allocated == 0) {
+                    ++wrong[i];
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(wrong, std::vector<int>(Threads)) << "executions per thread with a wrong result or live bytes";
+}
+
+TEST(CompiledScript, CompilesFromAStream) {
+    std::istringstream source{"let double = fn(x) { x * 2 };\ndouble(21)"};
+    std::vector<std::string> errors;
+    const auto script = script::CompiledScript::Compile(source, {}, errors);
+    ASSERT_NE(script, nullptr) << (errors.empty() ? "" : errors[0]);
+    EXPECT_EQ(script::Inspect(script->Execute().value), "42");
+}
+
+TEST(CompiledScript, LimitsEndRunawayScripts) {
+    std::vector<std::string> errors;
+    const auto script = script::CompiledScript::Compile(
+        "let spin = fn(n) { if (n == 0) { 0 } else { spin(n - 1) } }; spin(depth)", {"depth"}, errors);
+    ASSERT_NE(script, nullptr) << (errors.empty() ? "" : errors[0]);
+
+    const auto calls = std::vector<script::Value>{int64_t{99}};
+    EXPECT_EQ(script->Execute(calls, {.fuel = 100}).value, script::Value{int64_t{0}});
+    EXPECT_EQ(script->Execute(calls, {.fuel = 99}).error, "fuel exhausted");
+    // Running out of fuel does not carry over to the next execution.
+    EXPECT_EQ(script->Execute(calls).error, "");
+
+    const auto slow = script::CompiledScript::Compile(
+        "let fib = fn(n) { if (n < 2) { n } else { fib(n - 1) + fib(n - 2) } }; fib(40)", {}, errors);
+    ASSERT_NE(slow, nullptr);
+    EXPECT_EQ(slow->Execute({}, {.timeout = std::chrono::milliseconds{20}}).error, "timeout");
+}
+
+TEST(CompiledScript, DeepRecursionFails) {
+    std::vector<std::string> errors;
+    const auto script = script::CompiledScript::Compile(
+        "let f = fn(n) { if (n == 0) { 0 } else { 1 + f(n - 1) } }; f(depth)", {"depth"}, errors);
+    ASSERT_NE(script, nullptr) << (errors.empty() ? "" : errors[0]);
+
+    const auto deep = script->Execute(std::vector<script::Value>{int64_t{10000000}},
+                                      {.fuel = 100000000, .memory = 1 << 20});
+    EXPECT_EQ(deep.error, "stack overflow");
+    EXPECT_EQ(deep.usage.live, 0);
+    // The calls unwound by the error no longer count.
+    EXPECT_EQ(script->Execute(std::vector<script::Value>{int64_t{1000}}).value, script::Value{int64_t{1000}});
+}
+
+TEST(CompiledScript, AccountsForMemory) {
+    std::vector<std::string> errors;
+    // Every level keeps a closure over the one below alive until it returns.
+    const auto script = script::CompiledScript::Compile(
+        "let nest = fn(n) { if (n == 0) { 0 } else { let inner = fn() { n }; nest(n - 1) + inner() } }; nest(depth)",
+        {"depth"}, errors);
+    ASSERT_NE(script, nullptr) << (errors.empty() ? "" : errors[0]);
+
+    const auto shallow = script->Execute(std::vector<script::Value>{int64_t{10}});
+    ASSERT_EQ(shallow.error, "");
+    const auto deep = script->Execute(std::vector<script::Value>{int64_t{100}});
+    ASSERT_EQ(deep.error, "");
+    EXPECT_GT(deep.usage.peak, shallow.usage.peak * 5);
+    EXPECT_GE(deep.usage.allocated, deep.usage.peak);
+    EXPECT_EQ(shallow.usage.live, 0);
+    EXPECT_EQ(deep.usage.live, 0);
+
+    const auto limited = script->Execute(std::vector<script::Value>{int64_t{100}}, {.memory = shallow.usage.peak * 2});
+    EXPECT_EQ(limited.error, "out of memory");
+    EXPECT_LE(limited.usage.peak, shallow.usage.peak * 2);
+    EXPECT_EQ(limited.usage.live, 0);
+    EXPECT_EQ(script->Execute(std::vector<script::Value>{int64_t{10}}, {.memory = shallow.usage.peak}).error, "");
+}
+
+TEST(CompiledScript, ReleasesRecursiveClosures) {
+    const std::vector<std::pair<std::string, int64_t>> cases{
+        {"let fib = fn(n) { if (n < 2) { n } else { fib(n - 1) + fib(n - 2) } }; fib(10)", 55},
+        {"let count = fn(n) { let go = fn(i) { if (i == 0) { 0 } else { 1 + go(i - 1) } }; go(n) }; count(10)", 10},
+        {"let adder = fn(x) { let go = fn(y) { if (y == 0) { x } else { go(y - 1) } }; fn(y) { go(y) } }; adder(3)(4)", 3},
+        {"let f = fn() { let g = fn() { x }; let x = 7; g }; f()()", 7},
+        {"let make = fn() { let a = fn(n) { if (n == 0) { 0 } else { b(n - 1) } }; let b = fn(n) { a(n) }; a }; "
+         "make()(3)", 0},
+        {"let make = fn() { let f = fn(n) { if (n == 0) { 0 } else { f(n - 1) } }; f }; let h = make(); h(3)", 0},
+    };
+    for (const auto& [source, expected] : cases) {
+        std::vector<std::string> errors;
+        const auto script = script::CompiledScript::Compile(source, {}, errors);
+        ASSERT_NE(script, nullptr) << source;
+        const auto result = script->Execute({});
+        EXPECT_EQ(result.error, "") << source;
+        EXPECT_EQ(result.value, script::Value{expected}) << source;
+        EXPECT_EQ(result.usage.live, 0) << source;
+    }
+}
+
+TEST(CompiledScript, ReportsErrors) {
+    std::vector<std::string> errors;
+    EXPECT_EQ(script::CompiledScript::Compile("let = 1;", {}, errors), nullptr);
+    ASSERT_EQ(errors.size(), 1);
+    EXPECT_EQ(errors[0], "1:5: expected next token to be IDENT, got = instead");
+
+    const auto script = script::CompiledScript::Compile("fn(x) { x }(1) / 0", {}, errors);
+    ASSERT_NE(script, nullptr);
+    EXPECT_EQ(script->Execute().error, "division by zero");
+
+    const auto mistyped = script::CompiledScript::Compile(
+        "let g = fn() { let b = true; f(b) }; let f = fn(n) { let k = n; k + 1 }; f(1); g();", {}, errors);
+    ASSERT_NE(mistyped, nullptr);
+    EXPECT_EQ(mistyped->Execute().error, "type mismatch: BOOLEAN + INTEGER");
+
+    const auto capacity = symbols::Capacity();
+    symbols::SetCapacity(symbols::Bytes());
+    errors.clear();
+    EXPECT_EQ(script::CompiledScript::Compile("let scriptTestUnseen = 1;", {}, errors), nullptr);
+    symbols::SetCapacity(capacity);
+    ASSERT_EQ(errors.size(), 1);
+    EXPECT_EQ(errors[0], "too many distinct names");
+}
+
+TEST(CompiledScript, ReportsWhyItCannotBuild) {
+    std::vector<std::string> errors;
+    EXPECT_EQ(script::CompiledScript::Compile("1", {}, errors, {.compiler = "monkey-no-such-compiler"}), nullptr);
+    ASSERT_EQ(errors.size(), 1);
+    EXPECT_EQ(errors[0], "cannot run the compiler monkey-no-such-compiler: No such file or directory");
+
+    // Flags reach the compiler as arguments, never through a shell.
+    errors.clear();
+    EXPECT_EQ(script::CompiledScript::Compile("1", {}, errors, {.flags = "-O0 ;true"}), nullptr);
+    ASSERT_EQ(errors.size(), 1);
+    EXPECT_TRUE(errors[0].starts_with("cannot build the script: c++ -std=c++20 -O0 ;true -shared")) << errors[0];
+
+    const std::string tmpdir = std::getenv("TMPDIR") ? std::getenv("TMPDIR") : "";
+    ::setenv("TMPDIR", "/monkey-no-such-directory", 1);
+    errors.clear();
+    EXPECT_EQ(script::CompiledScript::Compile("1", {}, errors), nullptr);
+    tmpdir.empty() ? ::unsetenv("TMPDIR") : ::setenv("TMPDIR", tmpdir.c_str(), 1);
+    ASSERT_EQ(errors.size(), 1);
+    EXPECT_TRUE(errors[0].starts_with("cannot create a directory for the compiled script: ")) << errors[0];
+}
+
+TEST(CompiledScript, RejectsInputsThatAreNotIdentifiers) {
+    for (const std::string name : {"", "x1", "a-b", "x\")", "let", "true"}) {
+        std::vector<std::string> errors;
+        EXPECT_EQ(script::CompiledScript::Compile("1", {name}, errors), nullptr) << name;
+        ASSERT_EQ(errors.size(), 1) << name;
+        EXPECT_EQ(errors[0], "input name is not an identifier: " + name);
+    }
+}
+
+TEST(Session, RunsPiecesAgainstEarlierGlobals) {
+    script::Session session;
+    std::vector<std::string> errors;
+    const auto run = [&](std::string_view source) {
+        const auto result = session.Run(source, errors);
+        EXPECT_TRUE(result) << source << ": " << (errors.empty() ? "" : errors[0]);
+        return result.value_or(script::Result{});
+    };
+
+    EXPECT_EQ(run("let x = 5; let add = fn(a, b) { a + b };").error, "");
+    EXPECT_EQ(run("add(x, 2)").value, script::Value{int64_t{7}});
+    // Reads that never run do not fail, and a function may call one that a
+    // later piece declares.
+    EXPECT_EQ(run("if (false) { zz }; 1").value, script::Value{int64_t{1}});
+    EXPECT_EQ(run("zz").error, "identifier not found: zz");
+    run("let f = fn(n) { if (n == 0) { 0 } else { g(n - 1) } };");
+    run("let g = fn(n) { f(n) };");
+    EXPECT_EQ(run("f(10)").value, script::Value{int64_t{0}});
+
+    // A piece that fails at run time keeps what it bound before the error.
+    EXPECT_EQ(run("let y = 2; y / 0").error, "division by zero");
+    EXPECT_EQ(run("let x = true; add(x, y)").error, "type mismatch: BOOLEAN + INTEGER");
+
+    // One that cannot be built declares nothing.
+    EXPECT_FALSE(session.Run("let z = 1; let = 2", errors));
+    EXPECT_EQ(run("z").error, "identifier not found: z");
+}
+
+TEST(Session, ProfilesAPiece) {
+    script::Session session{{.flags = "-O0", .profile = true}};
+    std::vector<std::string> errors;
+    ASSERT_TRUE(session.Run("let fib = fn(n) { if (n < 2) { n } else { fib(n - 1) + fib(n - 2) } };", errors));
+
+    std::string folded;
+    const auto result = session.Profile("fib(22)", errors, folded);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(result->value, script::Value{int64_t{17711}});
+    // Frames of the function the earlier piece declared, under this piece's.
+    EXPECT_TRUE(folded.contains("program;fib:1:11")) << folded;
+
+    // Each profile starts from nothing.
+    folded.clear();
+    ASSERT_TRUE(session.Profile("1", errors, folded));
+    EXPECT_FALSE(folded.contains("fib")) << folded;
+}
@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include <stats/stats.h>
+
+TEST(Stats, ScopesRecordPhasesOfTheActiveReport) {
+    std::vector<std::unique_ptr<int[]>> kept;
+    kept.reserve(4);
+    {
+        const stats::Scope scope{"inactive"};
+        kept.push_back(std::make_unique<int[]>(16));
+    }
+
+    stats::Report report;
+    stats::Start(report);
+    {
+        const stats::Scope scope{"outer"};
+        kept.push_back(std::make_unique<int[]>(1000));
+        const stats::Scope inner{"inner"};
+        kept.push_back(std::make_unique<int[]>(10));
+    }
+    stats::Stop();
+    {
+        const stats::Scope scope{"stopped"};
+        kept.push_back(std::make_unique<int[]>(16));
+    }
+
+    ASSERT_EQ(report.phases.size(), 2);
+    EXPECT_EQ(report.phases[0].name, "outer");
+    EXPECT_EQ(report.phases[1].name, "inner");
+    EXPECT_GE(report.phases[0].allocations.count, 2);
+    EXPECT_GE(report.phases[0].allocations.bytes, 1010 * sizeof(int));
+    EXPECT_EQ(report.phases[1].allocations.count, 1);
+    EXPECT_EQ(report.phases[1].allocations.bytes, 10 * sizeof(int));
+    EXPECT_GE(report.phases[0].milliseconds, report.phases[1].milliseconds);
+}
+
+TEST(Stats, AllocationsAreCountedOnlyWhileAReportIsActive) {
+    const auto before = stats::Allocated();
+    auto kept = std::make_unique<int[]>(16);
+    EXPECT_EQ(stats::Allocated().count, before.count);
+}
+
+TEST(Stats, Json) {
+    stats::Report report;
+    report.phases.push_back({"lex", 1.5, {3, 96}});
+    report.tokens = 12;
+    report.nodes = {{"Identifier", 2}, {"LetStatement", 1}};
+
+    EXPECT_EQ(stats::Json(report), "{\"phases\": [{\"name\": \"lex\", \"ms\": 1.500, \"allocations\": 3, \"bytes\": 96}], "
+                                   "\"tokens\": 12, \"nodes\": {\"Identifier\": 2, \"LetStatement\": 1}}\n");
+}
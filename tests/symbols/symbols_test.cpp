@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ast/ast.h>
+#include <lexer/lexer.h>
+#include <parser/parser.h>
+#include <symbols/symbols.h>
+
+TEST(Symbols, InternReturnsOneSymbolPerName) {
+    const auto first = symbols::Intern("symbolsTestName");
+    const auto count = symbols::Count();
+
+    EXPECT_EQ(symbols::Intern(std::string{"symbolsTest"} + "Name"), first);
+    EXPECT_NE(symbols::Intern("symbolsTestOther"), first);
+    EXPECT_EQ(symbols::Count(), count + 1);
+    EXPECT_EQ(symbols::Name(first), "symbolsTestName");
+}
+
+TEST(Symbols, NamesCanBeReadWhileOthersAreInterned) {
+    const auto known = symbols::Intern("symbolsTestKnown");
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([t, known] {
+            for (int i = 0; i < 2000; ++i) {
+                const auto name = "symbolsTest" + std::to_string(t) + "x" + std::to_string(i);
+                const auto symbol = symbols::Intern(name);
+                EXPECT_EQ(symbols::Name(symbol), name);
+                EXPECT_EQ(symbols::Name(known), "symbolsTestKnown");
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_THROW(symbols::Name(static_cast<symbols::Symbol>(symbols::Count())), std::out_of_range);
+}
+
+TEST(Symbols, NewNamesFailOnceTheTableIsFull) {
+    const auto known = symbols::Intern("symbolsTestBeforeFull");
+    const auto capacity = symbols::Capacity();
+    symbols::SetCapacity(symbols::Bytes());
+
+    EXPECT_EQ(symbols::Intern("symbolsTestBeforeFull"), known);
+    EXPECT_THROW(symbols::Intern("symbolsTestAfterFull"), std::length_error);
+    auto p = Parser(lexer::Lexer("symbolsTestBeforeFull + 1"));
+    p.ParseProgram();
+    EXPECT_TRUE(p.Errors().empty());
+    EXPECT_THROW(Parser(lexer::Lexer("symbolsTestAfterFull")).ParseProgram(), std::length_error);
+
+    symbols::SetCapacity(capacity);
+    EXPECT_NO_THROW(symbols::Intern("symbolsTestAfterFull"));
+    EXPECT_GT(symbols::Bytes(), 0);
+}
+
+TEST(Symbols, IdentifiersShareInternedNames) {
+    auto p = Parser(lexer::Lexer("let counter = fn(counter) { counter + other }; counter"));
+    const auto program = p.ParseProgram();
+    ASSERT_TRUE(p.Errors().empty());
+
+    const auto let = dynamic_cast<ast::LetStatement*>(program.statements[0].get());
+    const auto literal = dynamic_cast<ast::FunctionLteral*>(let->value.get());
+    const auto body = dynamic_cast<ast::ExpressionStatement*>(literal->body->statements[0].get());
+    const auto infix = dynamic_cast<ast::InfixExpression*>(body->expression.get());
+    const auto use = dynamic_cast<ast::Identifier*>(infix->left.get());
+    const auto other = dynamic_cast<ast::Identifier*>(infix->right.get());
+
+    EXPECT_EQ(let->name.symbol, symbols::Intern("counter"));
+    EXPECT_EQ(literal->parameters[0]->symbol, let->name.symbol);
+    EXPECT_EQ(use->symbol, let->name.symbol);
+    EXPECT_NE(other->symbol, let->name.symbol);
+    EXPECT_EQ(use->value.data(), let->name.value.data());
+    EXPECT_EQ(other->value, "other");
+}
@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+
+#include <stats/stats.h>
+#include <trace/trace.h>
+
+namespace
+{
+
+std::size_t count(const std::string& text, const std::string& part) {
+    std::size_t n = 0;
+    for (auto at = text.find(part); at != std::string::npos; at = text.find(part, at + 1)) {
+        ++n;
+    }
+    return n;
+}
+
+} // namespace
+
+TEST(Trace, ScopesBecomeCompleteEvents) {
+    trace::Start("");
+    {
+        const stats::Scope scope{"parse"};
+    }
+    std::thread{[] {
+        const stats::Scope scope{"fold"};
+    }}.join();
+    const auto json = trace::Json();
+    trace::Stop();
+
+    EXPECT_TRUE(json.starts_with("{\"traceEvents\": ["));
+    EXPECT_NE(json.find("{\"name\": \"parse\", \"ph\": \"X\", \"ts\": "), std::string::npos);
+    EXPECT_NE(json.find("\"pid\": 1, \"tid\": 1}"), std::string::npos);
+    EXPECT_NE(json.find("{\"name\": \"fold\", \"ph\": \"X\", \"ts\": "), std::string::npos);
+    EXPECT_NE(json.find("\"pid\": 1, \"tid\": 2}"), std::string::npos);
+    EXPECT_TRUE(json.ends_with("\n]}\n"));
+
+    {
+        const stats::Scope scope{"stopped"};
+    }
+    EXPECT_EQ(trace::Json(), "{\"traceEvents\": [\n]}\n");
+}
+
+TEST(Trace, RingsKeepTheLatestSpans) {
+    trace::Start("", 3);
+    const auto now = std::chrono::steady_clock::now();
+    trace::Record("old", now, now);
+    for (int i = 0; i < 4; ++i) {
+        trace::Record("new", now, now);
+    }
+    const auto json = trace::Json();
+    trace::Stop();
+
+    EXPECT_EQ(count(json, "\"name\": \"old\""), 0);
+    EXPECT_EQ(count(json, "\"name\": \"new\""), 4);
+}
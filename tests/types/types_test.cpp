@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <ast/ast.h>
+#include <lexer/lexer.h>
+#include <parser/parser.h>
+#include <resolver/resolver.h>
+#include <types/types.h>
+
+namespace
+{
+
+ast::Program parse(const std::string& input) {
+    auto p = Parser(lexer::Lexer(input));
+    auto program = p.ParseProgram();
+    EXPECT_TRUE(p.Errors().empty());
+    return program;
+}
+
+ast::Expression* lastExpression(const ast::Program& program) {
+    return dynamic_cast<ast::ExpressionStatement*>(program.statements.back().get())->expression.get();
+}
+
+} // namespace
+
+TEST(Types, Literals) {
+    const std::vector<std::pair<std::string, types::Type>> tests{
+        {"5", types::Type::Integer},
+        {"-5 * 2", types::Type::Integer},
+        {"1 < 2", types::Type::Boolean},
+        {"!5", types::Type::Boolean},
+        {"true == 1", types::Type::Boolean},
+        {"1 + true", types::Type::Unknown},
+        {"-true", types::Type::Unknown},
+        {"fn(x) { x }", types::Type::Function},
+        {"if (x) { 1 } else { 2 }", types::Type::Integer},
+        {"if (x) { 1 }", types::Type::Unknown},
+        {"x + 1", types::Type::Unknown},
+    };
+    for (const auto& [input, expected] : tests) {
+        const auto program = parse(input);
+        const auto resolution = resolver::Resolve(program);
+        const auto inference = types::Infer(program, resolution);
+        EXPECT_EQ(inference.Of(lastExpression(program)), expected) << input;
+    }
+}
+
+TEST(Types, RecursiveIntegerFunction) {
+    const auto program = parse(R"(
+        let fib = fn(n) { if (n < 2) { return n; } fib(n - 1) + fib(n - 2) };
+        fib(20);
+    )");
+    const auto resolution = resolver::Resolve(program);
+    const auto inference = types::Infer(program, resolution);
+
+    EXPECT_EQ(inference.Of(lastExpression(program)), types::Type::Integer);
+    EXPECT_EQ(inference.integerOperations, 4);
+
+    const auto let = dynamic_cast<ast::LetStatement*>(program.statements[0].get());
+    const auto fib = dynamic_cast<ast::FunctionLteral*>(let->value.get());
+    const auto sum = dynamic_cast<ast::ExpressionStatement*>(fib->body->statements[1].get())->expression.get();
+    EXPECT_TRUE(inference.IntegerOnly(dynamic_cast<ast::InfixExpression*>(sum)));
+}
+
+TEST(Types, EscapingFunctionParametersStayUnknown) {
+    const auto program = parse("let id = fn(n) { n + 1 }; let alias = id; id(1);");
+    const auto resolution = resolver::Resolve(program);
+    const auto inference = types::Infer(program, resolution);
+
+    EXPECT_EQ(inference.Of(lastExpression(program)), types::Type::Unknown);
+    EXPECT_EQ(inference.integerOperations, 0);
+}
+
+TEST(Types, CallsReadBeforeTheLetKeepParametersUnknown) {
+    const auto program = parse("let g = fn() { let b = true; f(b) }; let f = fn(n) { let k = n; k + 1 }; f(1); g();");
+    const auto resolution = resolver::Resolve(program);
+    const auto inference = types::Infer(program, resolution);
+
+    EXPECT_EQ(inference.integerOperations, 0);
+}
+
+TEST(Types, CheckedArithmetic) {
+    int64_t result{};
+    EXPECT_EQ(types::Arithmetic(ast::Operator::Plus, 2, 3, result), types::Fault::None);
+    EXPECT_EQ(result, 5);
+    EXPECT_EQ(types::Arithmetic(ast::Operator::Slash, 7, -2, result), types::Fault::None);
+    EXPECT_EQ(result, -3);
+
+    result = 42;
+    EXPECT_EQ(types::Arithmetic(ast::Operator::Plus, INT64_MAX, 1, result), types::Fault::Overflow);
+    EXPECT_EQ(types::Arithmetic(ast::Operator::Minus, INT64_MIN, 1, result), types::Fault::Overflow);
+    EXPECT_EQ(types::Arithmetic(ast::Operator::Asterisk, INT64_MAX, 2, result), types::Fault::Overflow);
+    EXPECT_EQ(types::Arithmetic(ast::Operator::Slash, INT64_MIN, -1, result), types::Fault::Overflow);
+    EXPECT_EQ(types::Arithmetic(ast::Operator::Slash, 1, 0, result), types::Fault::DivisionByZero);
+    EXPECT_EQ(result, 42);
+    EXPECT_EQ(types::Describe(types::Fault::DivisionByZero), "division by zero");
+}